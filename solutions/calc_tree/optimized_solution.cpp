@@ -1,17 +1,27 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
-#include <stack>
-#include <memory>
+#include <string_view>
+#include <cctype>
+#include <climits>
+#include <numeric>
 #include <stdexcept>
-#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
 #include <iomanip>
+#include <span>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <vector>
 
 /**
  * @file optimized_solution.cpp
  * @brief Оптимизированная реализация калькулятора выражений
  * @details Оптимизировано на основе решений DeepSeek и GPT-4o
+ *
+ * Сборка: g++ -std=c++20 -O2 -march=native optimized_solution.cpp -pthread
  */
 
 // Класс исключения для обработки ошибок в выражениях
@@ -22,197 +32,918 @@ public:
     ExpressionError(const std::string& msg) : std::runtime_error(msg) {}
 };
 
-// Класс для представления узла в дереве выражений
-// Взято из решения DeepSeek
-// Использует умные указатели (std::shared_ptr) для автоматического управления памятью
-class TreeNode {
-public:
-    std::string value;  // Значение узла (оператор или операнд)
-    std::shared_ptr<TreeNode> left;  // Левый потомок узла
-    std::shared_ptr<TreeNode> right;  // Правый потомок узла
-    
-    // Создает новый узел с указанным значением
-    TreeNode(const std::string& val) : value(val), left(nullptr), right(nullptr) {}
+// Код операции узла дерева и инструкции байт-кода выражения
+enum class OpCode : std::uint8_t {
+    PushConst,  // Константа (лист дерева, в байт-коде - положить в стек)
+    PushX,      // Переменная x
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Mod,
+    Pow,
+    Neg         // Унарный минус (единственный потомок - левый)
+};
+
+// Номер узла в арене дерева
+using NodeIndex = std::uint32_t;
+constexpr NodeIndex kNoNode = UINT32_MAX;
+
+// Узел дерева выражений (16 байт)
+// Узлы дерева лежат в одном векторе (арене) ExpressionTree, потомки
+// задаются 32-битными номерами в нем. Вместо std::string и двух shared_ptr
+// в узле код операции и значение константы: построение дерева не выделяет
+// память на узел, счетчики ссылок не меняются, а арена освобождается целиком
+struct TreeNode {
+    OpCode op;                 // Оператор, константа или x
+    int value;                 // Значение константы
+    NodeIndex left = kNoNode;  // Левый потомок узла
+    NodeIndex right = kNoNode; // Правый потомок узла
+};
+static_assert(sizeof(TreeNode) == 16, "Узел дерева должен занимать 16 байт");
+
+// Вид лексемы выражения
+enum class TokenKind : std::uint8_t {
+    Number,
+    Variable,
+    Operator,
+    LeftParen,
+    RightParen,
+    End         // Конец выражения (всегда последняя лексема)
+};
+
+// Лексема выражения: вид, код операции оператора или листа, значение
+// числа и смещение лексемы от начала выражения
+struct Token {
+    TokenKind kind;
+    OpCode op;
+    int value;
+    std::uint32_t offset;
 };
 
+// Инструкция байт-кода: код операции и непосредственный операнд (8 байт)
+// Программа - обратная польская запись дерева, исполняемая на стеке
+struct Instruction {
+    OpCode op;
+    int operand;
+};
+
+// Результат вычисления выражения для одного значения x в пакетном режиме
+enum class EvalStatus : std::uint8_t {
+    Ok,
+    DivisionByZero,
+    ModuloByZero,
+    NegativePower,
+    Overflow
+};
+
+// Текст ошибки пакетного вычисления (тот же, что у исключений evaluate(int))
+inline const char* describe(EvalStatus status) {
+    switch (status) {
+        case EvalStatus::Ok: return "";
+        case EvalStatus::DivisionByZero: return "Деление на ноль";
+        case EvalStatus::ModuloByZero: return "Остаток от деления на ноль";
+        case EvalStatus::NegativePower: return "Отрицательная степень не поддерживается";
+        case EvalStatus::Overflow: return "Переполнение целого числа";
+    }
+    return "";
+}
+
+// Обработка переполнения int при вычислении выражения
+enum class OverflowPolicy : std::uint8_t {
+    Wrap,      // Результат по модулю 2^32 (дополнительный код)
+    Saturate,  // Ближайшее представимое значение: INT_MIN или INT_MAX
+    Throw      // Ошибка вычисления EvalStatus::Overflow
+};
+
+// Целочисленная арифметика выражений с проверкой переполнения
+// Сложение, вычитание и умножение проверяются встроенными функциями
+// компилятора __builtin_*_overflow, которые дают и результат по модулю 2^32.
+// Функции возвращают результат по политике Policy; при OverflowPolicy::Throw
+// переполнение отмечается в overflow, а ошибку бросает или записывает
+// вызывающий код
+namespace checked {
+
+// Результат операции по политике: wrapped - результат по модулю 2^32,
+// overflowed - было ли переполнение, negative - знак точного результата
+template <OverflowPolicy Policy>
+inline int resolve(int wrapped, bool overflowed, bool negative, bool& overflow) {
+    if (!overflowed) return wrapped;
+    if constexpr (Policy == OverflowPolicy::Saturate) return negative ? INT_MIN : INT_MAX;
+    if constexpr (Policy == OverflowPolicy::Throw) overflow = true;
+    return wrapped;
+}
+
+template <OverflowPolicy Policy>
+inline int add(int a, int b, bool& overflow) {
+    int result;
+    bool overflowed = __builtin_add_overflow(a, b, &result);
+    return resolve<Policy>(result, overflowed, a < 0, overflow);
+}
+
+template <OverflowPolicy Policy>
+inline int sub(int a, int b, bool& overflow) {
+    int result;
+    bool overflowed = __builtin_sub_overflow(a, b, &result);
+    return resolve<Policy>(result, overflowed, a < 0, overflow);
+}
+
+template <OverflowPolicy Policy>
+inline int mul(int a, int b, bool& overflow) {
+    int result;
+    bool overflowed = __builtin_mul_overflow(a, b, &result);
+    return resolve<Policy>(result, overflowed, (a < 0) != (b < 0), overflow);
+}
+
+// Частное a / b при b != 0; переполняется только INT_MIN / -1
+template <OverflowPolicy Policy>
+inline int div(int a, int b, bool& overflow) {
+    if (a == INT_MIN && b == -1) return resolve<Policy>(INT_MIN, true, false, overflow);
+    return a / b;
+}
+
+// Остаток a % b при b != 0 не переполняется; INT_MIN % -1 в процессоре
+// дает исключение, поэтому делитель -1 обрабатывается отдельно
+inline int mod(int a, int b) {
+    return b == -1 ? 0 : a % b;
+}
+
+template <OverflowPolicy Policy>
+inline int neg(int a, bool& overflow) {
+    return resolve<Policy>(a == INT_MIN ? INT_MIN : -a, a == INT_MIN, false, overflow);
+}
+
+// Возводит base в степень exponent >= 0 возведением в квадрат:
+// не больше 31 умножения без перехода через double
+// Квадрат основания вычисляется, только если в показателе остались старшие
+// биты, поэтому переполнение квадрата означает переполнение результата.
+// Умножение по модулю 2^32 сохраняет результат по модулю 2^32, поэтому
+// после переполнения цепочка умножений продолжается для OverflowPolicy::Wrap
+template <OverflowPolicy Policy>
+inline int pow(int base, int exponent, bool& overflow) {
+    bool negative = base < 0 && (exponent & 1);
+    bool overflowed = false;
+    int result = 1;
+    while (true) {
+        if (exponent & 1) overflowed |= __builtin_mul_overflow(result, base, &result);
+        exponent >>= 1;
+        if (exponent == 0) break;
+        overflowed |= __builtin_mul_overflow(base, base, &base);
+    }
+    return resolve<Policy>(result, overflowed, negative, overflow);
+}
+
+}  // namespace checked
+
 // Основной класс для работы с деревом выражений
 // Объединяет функциональность из решений DeepSeek, Mistral и GPT-4o
 class ExpressionTree {
 private:
-    std::shared_ptr<TreeNode> root;
+    std::vector<TreeNode> nodes;  // Арена узлов дерева
+    std::vector<TreeNode> spare;  // Арена, в которой строится следующее дерево
+    NodeIndex root = kNoNode;
+    std::vector<Token> tokens;  // Лексемы последнего разобранного выражения
+    std::size_t cursor = 0;     // Номер текущей лексемы при разборе
+    std::vector<Instruction> program;  // Байт-код дерева (постфиксный обход)
+    std::vector<int> stack;  // Стек вычислений размером с наибольшую глубину программы
+    OverflowPolicy overflowPolicy = OverflowPolicy::Throw;
+    
+    // Число значений x в блоке пакетного вычисления: стек блока (глубина
+    // программы x 4 КБ) остается в кэше
+    static constexpr std::size_t kBatchBlock = 1024;
+    
+    // Допустимый диапазон чисел в выражении
+    // Взято из решения DeepSeek: ограничение от 1 до 30 предотвращает переполнение
+    static constexpr int kMinConstant = 1;
+    static constexpr int kMaxConstant = 30;
+    
+    // Наибольшая вложенность скобок и унарных минусов: ограничивает глубину
+    // рекурсии разбора
+    static constexpr int kMaxNesting = 256;
     
     // Определяет приоритет оператора
     // Взято из решения DeepSeek
     // Увеличен приоритет степени (^) до 4, что соответствует математическим правилам
-    int getPriority(const std::string& op) {
-        if (op == "^") return 4;
-        if (op == "*" || op == "/" || op == "%") return 3;
-        if (op == "+" || op == "-") return 2;
-        return 0;
+    static int getPriority(OpCode op) {
+        switch (op) {
+            case OpCode::Pow: return 4;
+            case OpCode::Mul: case OpCode::Div: case OpCode::Mod: return 3;
+            case OpCode::Add: case OpCode::Sub: return 2;
+            default: return 0;
+        }
     }
     
-    // Проверяет, является ли строка оператором
-    bool isOperator(const std::string& c) {
-        return c == "+" || c == "-" || c == "*" || c == "/" || c == "%" || c == "^";
+    // Код операции оператора, записанного одним символом
+    static OpCode operatorCode(char c) {
+        switch (c) {
+            case '+': return OpCode::Add;
+            case '-': return OpCode::Sub;
+            case '*': return OpCode::Mul;
+            case '/': return OpCode::Div;
+            case '%': return OpCode::Mod;
+            default: return OpCode::Pow;
+        }
     }
     
-    // Проверяет, является ли строка допустимым числом
-    // Взято из решения DeepSeek
-    // Добавлена проверка диапазона (от 1 до 30) для предотвращения переполнения
-    bool isValidNumber(const std::string& num) {
-        try {
-            int val = std::stoi(num);
-            return val >= 1 && val <= 30;
-        } catch (...) {
-            return false;
+    // Запись узла при печати дерева
+    static std::string label(const TreeNode& node) {
+        switch (node.op) {
+            case OpCode::PushConst: return std::to_string(node.value);
+            case OpCode::PushX: return "x";
+            case OpCode::Add: return "+";
+            case OpCode::Sub: return "-";
+            case OpCode::Mul: return "*";
+            case OpCode::Div: return "/";
+            case OpCode::Mod: return "%";
+            case OpCode::Pow: return "^";
+            case OpCode::Neg: return "-";
         }
+        return "";
+    }
+    
+    // Исключение с позицией лексемы (с единицы) в тексте выражения
+    static ExpressionError errorAt(const std::string& msg, std::uint32_t offset) {
+        return ExpressionError(msg + " (позиция " + std::to_string(offset + 1) + ")");
     }
     
-    // Разбивает выражение на токены
+    // Разбивает выражение на лексемы за один проход по символам
     // Взято из решения DeepSeek
-    // Улучшена проверка токенов с использованием функций isOperator и isValidNumber
-    std::vector<std::string> tokenize(const std::string& expr) {
-        std::vector<std::string> tokens;
-        std::istringstream iss(expr);
-        std::string token;
-        
-        while (iss >> token) {
-            if (token == "x" || isOperator(token) || isValidNumber(token)) {
-                tokens.push_back(token);
-            } else {
-                throw ExpressionError("Недопустимый токен: " + token);
+    // Вместо istringstream и std::stoi в try/catch символы разбираются вручную:
+    // пробелы между лексемами не обязательны (2*x, (x+1)), число переводится
+    // в int при чтении, а лексемы пишутся в буфер tokens, память которого
+    // переиспользуется при следующем разборе. Слово из букв и цифр - это x
+    // или число от kMinConstant до kMaxConstant
+    void tokenize(std::string_view expr) {
+        if (expr.size() >= UINT32_MAX) {
+            throw ExpressionError("Слишком длинное выражение");
+        }
+        tokens.clear();
+        std::size_t i = 0;
+        while (i < expr.size()) {
+            auto c = static_cast<unsigned char>(expr[i]);
+            auto offset = static_cast<std::uint32_t>(i);
+            if (std::isspace(c)) {
+                ++i;
+                continue;
+            }
+            
+            if (std::isalnum(c)) {
+                std::size_t end = i;
+                bool digits = true;
+                int value = 0;
+                for (; end < expr.size() && std::isalnum(static_cast<unsigned char>(expr[end])); ++end) {
+                    digits = digits && std::isdigit(static_cast<unsigned char>(expr[end]));
+                    // После превышения kMaxConstant значение не растет дальше,
+                    // поэтому длинное число не переполняет int
+                    if (digits && value <= kMaxConstant) value = value * 10 + (expr[end] - '0');
+                }
+                std::string_view word = expr.substr(i, end - i);
+                if (word == "x") {
+                    tokens.push_back({TokenKind::Variable, OpCode::PushX, 0, offset});
+                } else if (digits && value >= kMinConstant && value <= kMaxConstant) {
+                    tokens.push_back({TokenKind::Number, OpCode::PushConst, value, offset});
+                } else {
+                    throw errorAt("Недопустимый токен: " + std::string(word), offset);
+                }
+                i = end;
+                continue;
             }
+            
+            switch (c) {
+                case '(':
+                    tokens.push_back({TokenKind::LeftParen, OpCode::PushConst, 0, offset});
+                    break;
+                case ')':
+                    tokens.push_back({TokenKind::RightParen, OpCode::PushConst, 0, offset});
+                    break;
+                case '+': case '-': case '*': case '/': case '%': case '^':
+                    tokens.push_back({TokenKind::Operator, operatorCode(static_cast<char>(c)), 0, offset});
+                    break;
+                default:
+                    throw errorAt("Недопустимый токен: " + std::string(1, static_cast<char>(c)), offset);
+            }
+            ++i;
         }
         
         if (tokens.empty()) {
             throw ExpressionError("Пустое выражение");
         }
+        tokens.push_back({TokenKind::End, OpCode::PushConst, 0, static_cast<std::uint32_t>(expr.size())});
+    }
+    
+    // Добавляет узел в арену и возвращает его номер
+    static NodeIndex append(std::vector<TreeNode>& arena, TreeNode node) {
+        arena.push_back(node);
+        return static_cast<NodeIndex>(arena.size() - 1);
+    }
+    
+    // Разбирает операнд: число, x, выражение в скобках или унарный минус
+    // Унарный минус связывает слабее степени и сильнее остальных
+    // операторов: -x ^ 2 = -(x ^ 2), -2 * x = (-2) * x
+    NodeIndex parseOperand(std::vector<TreeNode>& arena, int nesting) {
+        const Token& token = tokens[cursor];
+        switch (token.kind) {
+            case TokenKind::Number:
+            case TokenKind::Variable:
+                ++cursor;
+                return append(arena, {token.op, token.value});
+            case TokenKind::LeftParen: {
+                ++cursor;
+                NodeIndex inner = parseExpression(arena, getPriority(OpCode::Add), nesting + 1);
+                if (tokens[cursor].kind != TokenKind::RightParen) {
+                    throw errorAt("Ожидалась закрывающая скобка", tokens[cursor].offset);
+                }
+                ++cursor;
+                return inner;
+            }
+            case TokenKind::Operator:
+                if (token.op == OpCode::Sub) {
+                    ++cursor;
+                    NodeIndex operand = parseExpression(arena, getPriority(OpCode::Pow), nesting + 1);
+                    return append(arena, {OpCode::Neg, 0, operand});
+                }
+                [[fallthrough]];
+            default:
+                throw errorAt("Ожидался операнд", token.offset);
+        }
+    }
+    
+    // Разбирает выражение из операторов с приоритетом не ниже minPriority
+    // методом подъема по приоритетам (precedence climbing)
+    // Правый операнд разбирается с приоритетом на единицу выше, поэтому все
+    // операторы, включая степень, левоассоциативны - как при построении дерева
+    // сортировочной станцией в прежней версии (решение GPT-4o)
+    NodeIndex parseExpression(std::vector<TreeNode>& arena, int minPriority, int nesting) {
+        if (nesting > kMaxNesting) {
+            throw errorAt("Слишком глубокая вложенность", tokens[cursor].offset);
+        }
+        NodeIndex left = parseOperand(arena, nesting);
+        while (tokens[cursor].kind == TokenKind::Operator && getPriority(tokens[cursor].op) >= minPriority) {
+            OpCode op = tokens[cursor++].op;
+            NodeIndex right = parseExpression(arena, getPriority(op) + 1, nesting);
+            left = append(arena, {op, 0, left, right});
+        }
+        return left;
+    }
+    
+    // Строит дерево выражения из лексем tokens в арене arena
+    // Узлов не больше, чем лексем, поэтому память арены выделяется один раз
+    NodeIndex buildTreeFromTokens(std::vector<TreeNode>& arena) {
+        arena.clear();
+        arena.reserve(tokens.size());
+        cursor = 0;
+        NodeIndex top = parseExpression(arena, getPriority(OpCode::Add), 0);
         
-        return tokens;
+        const Token& rest = tokens[cursor];
+        if (rest.kind == TokenKind::RightParen) {
+            throw errorAt("Лишняя закрывающая скобка", rest.offset);
+        }
+        if (rest.kind != TokenKind::End) {
+            throw errorAt("Ожидался оператор", rest.offset);
+        }
+        return top;
     }
     
-    // Строит дерево выражения из токенов
-    // Взято из решения GPT-4o
-    // Использует лямбда-функцию для применения операторов, что делает код более компактным
-    std::shared_ptr<TreeNode> buildTreeFromTokens(const std::vector<std::string>& tokens) {
-        std::stack<std::shared_ptr<TreeNode>> nodes;
-        std::stack<std::string> ops;
+    // Компилирует поддерево в байт-код постфиксным обходом
+    // Код операции узла переходит в инструкцию без изменений. depth - глубина
+    // стека после выполнения уже выданных инструкций, maxDepth - ее максимум
+    void compileNode(NodeIndex index, int& depth, int& maxDepth) {
+        const TreeNode& node = nodes[index];
+        if (node.op == OpCode::PushX || node.op == OpCode::PushConst) {
+            program.push_back({node.op, node.value});
+            maxDepth = std::max(maxDepth, ++depth);
+            return;
+        }
+        if (node.op == OpCode::Neg) {
+            compileNode(node.left, depth, maxDepth);
+            program.push_back({node.op, 0});
+            return;
+        }
         
-        auto applyOp = [&]() {
-            if (nodes.size() < 2) {
-                throw ExpressionError("Недостаточно операндов для оператора");
+        compileNode(node.left, depth, maxDepth);
+        compileNode(node.right, depth, maxDepth);
+        program.push_back({node.op, 0});
+        --depth;
+    }
+    
+    // Компилирует дерево в байт-код и выделяет стек вычислений
+    void compile() {
+        program.clear();
+        program.reserve(nodes.size());
+        int depth = 0, maxDepth = 0;
+        compileNode(root, depth, maxDepth);
+        stack.assign(maxDepth, 0);
+    }
+    
+    // Вызывает f(std::integral_constant<OverflowPolicy, P>{}) для текущей
+    // политики P: внутренние циклы вычисления конкретизируются для каждой
+    // политики, и ее выбор не проверяется на каждой операции
+    template <typename F>
+    decltype(auto) withOverflowPolicy(F&& f) const {
+        switch (overflowPolicy) {
+            case OverflowPolicy::Wrap:
+                return f(std::integral_constant<OverflowPolicy, OverflowPolicy::Wrap>{});
+            case OverflowPolicy::Saturate:
+                return f(std::integral_constant<OverflowPolicy, OverflowPolicy::Saturate>{});
+            default:
+                return f(std::integral_constant<OverflowPolicy, OverflowPolicy::Throw>{});
+        }
+    }
+    
+    // Исполняет байт-код для данного x
+    // Взято из evaluateNode решения DeepSeek: те же проверки деления на ноль,
+    // остатка от деления на ноль и отрицательной степени. Постфиксный порядок
+    // совпадает с порядком рекурсивного обхода (левое поддерево, правое,
+    // оператор), поэтому при нескольких ошибках сообщается та же, что и при
+    // обходе дерева.
+    // Цикл выполняет одну инструкцию за итерацию без рекурсии, указателей
+    // на узлы и сравнения строк; вершина стека хранится в указателе.
+    // Операции выполняются через checked с политикой переполнения Policy
+    template <OverflowPolicy Policy>
+    int execute(int x) {
+        int* top = stack.data();  // Первая свободная ячейка стека
+        bool overflow = false;
+        for (const Instruction& instruction : program) {
+            switch (instruction.op) {
+                case OpCode::PushConst:
+                    *top++ = instruction.operand;
+                    break;
+                case OpCode::PushX:
+                    *top++ = x;
+                    break;
+                case OpCode::Add:
+                    --top;
+                    top[-1] = checked::add<Policy>(top[-1], top[0], overflow);
+                    break;
+                case OpCode::Sub:
+                    --top;
+                    top[-1] = checked::sub<Policy>(top[-1], top[0], overflow);
+                    break;
+                case OpCode::Mul:
+                    --top;
+                    top[-1] = checked::mul<Policy>(top[-1], top[0], overflow);
+                    break;
+                case OpCode::Div:
+                    --top;
+                    if (top[0] == 0) throw ExpressionError("Деление на ноль");
+                    top[-1] = checked::div<Policy>(top[-1], top[0], overflow);
+                    break;
+                case OpCode::Mod:
+                    --top;
+                    if (top[0] == 0) throw ExpressionError("Остаток от деления на ноль");
+                    top[-1] = checked::mod(top[-1], top[0]);
+                    break;
+                case OpCode::Pow:
+                    --top;
+                    if (top[0] < 0) throw ExpressionError("Отрицательная степень не поддерживается");
+                    top[-1] = checked::pow<Policy>(top[-1], top[0], overflow);
+                    break;
+                case OpCode::Neg:
+                    top[-1] = checked::neg<Policy>(top[-1], overflow);
+                    break;
+            }
+            if constexpr (Policy == OverflowPolicy::Throw) {
+                if (overflow) throw ExpressionError(describe(EvalStatus::Overflow));
+            }
+        }
+        return top[-1];
+    }
+    
+    // Вычисляет операцию над константами так же, как execute (для Neg
+    // используется только left)
+    // Возвращает false, если операция дала бы ошибку или переполнение:
+    // такое поддерево не сворачивается, и при вычислении ошибка или результат
+    // переполнения определяются политикой, действующей в момент вычисления
+    static bool foldConstants(OpCode op, int left, int right, int& result) {
+        constexpr OverflowPolicy Policy = OverflowPolicy::Throw;
+        bool overflow = false;
+        switch (op) {
+            case OpCode::Add: result = checked::add<Policy>(left, right, overflow); break;
+            case OpCode::Sub: result = checked::sub<Policy>(left, right, overflow); break;
+            case OpCode::Mul: result = checked::mul<Policy>(left, right, overflow); break;
+            case OpCode::Div:
+                if (right == 0) return false;
+                result = checked::div<Policy>(left, right, overflow);
+                break;
+            case OpCode::Mod:
+                if (right == 0) return false;
+                result = checked::mod(left, right);
+                break;
+            case OpCode::Pow:
+                if (right < 0) return false;
+                result = checked::pow<Policy>(left, right, overflow);
+                break;
+            case OpCode::Neg: result = checked::neg<Policy>(left, overflow); break;
+            default: return false;
+        }
+        return !overflow;
+    }
+    
+    // Записывает в a[i] 64-битный результат wide(i) по политике Policy
+    // Точный результат сложения, вычитания, умножения, частного и отрицания
+    // 32-битных чисел помещается в 64 бита, поэтому переполнение - выход за
+    // пределы int, а сужение и насыщение векторизуются. При
+    // OverflowPolicy::Throw переполнение записывается в status отдельным
+    // циклом до записи результата
+    template <OverflowPolicy Policy, typename Wide>
+    static void storeBlock(int* __restrict a, EvalStatus* __restrict status, Wide wide) {
+        constexpr std::size_t count = kBatchBlock;
+        if constexpr (Policy == OverflowPolicy::Throw) {
+            for (std::size_t i = 0; i < count; ++i) {
+                long long value = wide(i);
+                bool overflowed = value < INT_MIN || value > INT_MAX;
+                status[i] = overflowed && status[i] == EvalStatus::Ok ? EvalStatus::Overflow : status[i];
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            long long value = wide(i);
+            if constexpr (Policy == OverflowPolicy::Saturate) {
+                value = value < INT_MIN ? INT_MIN : value > INT_MAX ? INT_MAX : value;
+            }
+            a[i] = static_cast<int>(static_cast<std::uint32_t>(value));
+        }
+    }
+    
+    // Выполняет операцию над блоком: a[i] = a[i] op b[i]
+    // Длина блока - константа kBatchBlock, а a и b объявлены __restrict (это
+    // разные ячейки стека), поэтому циклы векторизуются компилятором уже при
+    // -O2: без скалярного хвоста и без проверки пересечения массивов.
+    // Деление выполняется в double с отбрасыванием дробной части: для 32-битных
+    // целых частное точное, а деление double, в отличие от целочисленного,
+    // есть в SIMD. Остаток - a - (a / b) * b. Нулевой делитель или отрицательная
+    // степень записывает ошибку в status, если ошибки еще не было (так
+    // сообщается первая ошибка, как у evaluate(int)), и заменяется безопасным
+    // операндом. Ошибки отмечаются отдельным циклом над байтами status.
+    // Переполнение обрабатывается по политике Policy (см. storeBlock), степень
+    // вычисляется checked::pow для каждого значения
+    template <OverflowPolicy Policy>
+    static void applyBlock(OpCode op, int* __restrict a, const int* __restrict b, EvalStatus* __restrict status) {
+        constexpr std::size_t count = kBatchBlock;
+        auto flag = [&](EvalStatus error, auto failed) {
+            for (std::size_t i = 0; i < count; ++i) {
+                status[i] = failed(b[i]) && status[i] == EvalStatus::Ok ? error : status[i];
             }
-            
-            std::string op = ops.top(); ops.pop();
-            auto right = nodes.top(); nodes.pop();
-            auto left = nodes.top(); nodes.pop();
-            
-            auto newNode = std::make_shared<TreeNode>(op);
-            newNode->left = left;
-            newNode->right = right;
-            nodes.push(newNode);
         };
-        
-        for (const auto& token : tokens) {
-            if (token == "x" || isValidNumber(token)) {
-                nodes.push(std::make_shared<TreeNode>(token));
-            } else if (isOperator(token)) {
-                while (!ops.empty() && getPriority(ops.top()) >= getPriority(token)) {
-                    applyOp();
+        auto isZero = [](int value) { return value == 0; };
+        auto quotient = [](int left, int right) {
+            return static_cast<long long>(static_cast<double>(left) / static_cast<double>(right));
+        };
+        switch (op) {
+            case OpCode::Add:
+                storeBlock<Policy>(a, status, [&](std::size_t i) { return static_cast<long long>(a[i]) + b[i]; });
+                break;
+            case OpCode::Sub:
+                storeBlock<Policy>(a, status, [&](std::size_t i) { return static_cast<long long>(a[i]) - b[i]; });
+                break;
+            case OpCode::Mul:
+                storeBlock<Policy>(a, status, [&](std::size_t i) { return static_cast<long long>(a[i]) * b[i]; });
+                break;
+            case OpCode::Div:
+                flag(EvalStatus::DivisionByZero, isZero);
+                storeBlock<Policy>(a, status, [&](std::size_t i) { return quotient(a[i], b[i] + (b[i] == 0)); });
+                break;
+            case OpCode::Mod:
+                flag(EvalStatus::ModuloByZero, isZero);
+                for (std::size_t i = 0; i < count; ++i) {
+                    int divisor = b[i] + (b[i] == 0);
+                    a[i] = static_cast<int>(a[i] - quotient(a[i], divisor) * divisor);
                 }
-                ops.push(token);
-            }
+                break;
+            case OpCode::Pow:
+                flag(EvalStatus::NegativePower, [](int value) { return value < 0; });
+                for (std::size_t i = 0; i < count; ++i) {
+                    bool overflow = false;
+                    a[i] = checked::pow<Policy>(a[i], b[i] < 0 ? 0 : b[i], overflow);
+                    if (overflow && status[i] == EvalStatus::Ok) status[i] = EvalStatus::Overflow;
+                }
+                break;
+            default:
+                break;
         }
+    }
+    
+    // Рабочая память потока для пакетного вычисления: стек блока (ячейка
+    // стека - массив из kBatchBlock значений), значения x неполного блока
+    // и ошибки блока
+    struct BlockScratch {
+        std::vector<int> slots;
+        std::vector<int> input;
+        std::vector<EvalStatus> status;
         
-        while (!ops.empty()) {
-            applyOp();
+        explicit BlockScratch(std::size_t depth)
+            : slots(depth * kBatchBlock), input(kBatchBlock), status(kBatchBlock) {}
+    };
+    
+    // Вычисляет программу для блока из count <= kBatchBlock значений x
+    // Каждая инструкция выполняется сразу над всем блоком. Неполный блок
+    // дополняется копиями последнего x, так что дополнение не дает новых ошибок.
+    // Для значений с ошибкой в out записывается 0
+    template <OverflowPolicy Policy>
+    void executeBlock(const int* xs, int* out, EvalStatus* status, std::size_t count, BlockScratch& scratch) const {
+        if (count < kBatchBlock) {
+            std::copy(xs, xs + count, scratch.input.begin());
+            std::fill(scratch.input.begin() + static_cast<std::ptrdiff_t>(count), scratch.input.end(), xs[count - 1]);
+            xs = scratch.input.data();
         }
-        
-        if (nodes.size() != 1) {
-            throw ExpressionError("Некорректное выражение");
+        EvalStatus* lanes = scratch.status.data();
+        std::fill(lanes, lanes + kBatchBlock, EvalStatus::Ok);
+        int* top = scratch.slots.data();  // Первая свободная ячейка стека
+        for (const Instruction& instruction : program) {
+            switch (instruction.op) {
+                case OpCode::PushConst:
+                    std::fill(top, top + kBatchBlock, instruction.operand);
+                    top += kBatchBlock;
+                    break;
+                case OpCode::PushX:
+                    std::copy(xs, xs + kBatchBlock, top);
+                    top += kBatchBlock;
+                    break;
+                case OpCode::Neg: {
+                    int* a = top - kBatchBlock;
+                    storeBlock<Policy>(a, lanes, [&](std::size_t i) { return -static_cast<long long>(a[i]); });
+                    break;
+                }
+                default:
+                    top -= kBatchBlock;
+                    applyBlock<Policy>(instruction.op, top - kBatchBlock, top, lanes);
+                    break;
+            }
+        }
+        const int* result = top - kBatchBlock;
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = lanes[i] == EvalStatus::Ok ? result[i] : 0;
+            status[i] = lanes[i];
         }
-        
-        return nodes.top();
     }
     
-    // Вычисляет значение поддерева с корнем в данном узле
+    // Преобразует поддерево по правилу x*A → A*x
     // Взято из решения DeepSeek
-    // Добавлена проверка деления на ноль и остатка от деления на ноль
-    int evaluateNode(const std::shared_ptr<TreeNode>& node, int x) {
-        if (!node) return 0;
-        
-        if (node->value == "x") return x;
-        if (!isOperator(node->value)) return std::stoi(node->value);
+    // Использует рекурсивный подход для обхода всего дерева
+    void transformNode(NodeIndex index) {
+        if (index == kNoNode) return;
+        TreeNode& node = nodes[index];
         
-        int left = evaluateNode(node->left, x);
-        int right = evaluateNode(node->right, x);
+        transformNode(node.left);
+        transformNode(node.right);
         
-        if (node->value == "+") return left + right;
-        if (node->value == "-") return left - right;
-        if (node->value == "*") return left * right;
-        if (node->value == "/") {
-            if (right == 0) throw ExpressionError("Деление на ноль");
-            return left / right;
+        if (node.op == OpCode::Mul && nodes[node.left].op == OpCode::PushX) {
+            std::swap(node.left, node.right);
         }
-        if (node->value == "%") {
-            if (right == 0) throw ExpressionError("Остаток от деления на ноль");
-            return left % right;
+    }
+    
+    // Может ли узел-оператор дать ошибку при вычислении: деление и остаток
+    // на ноль, отрицательная степень и переполнение (при OverflowPolicy::Throw;
+    // политика может смениться после упрощения, поэтому оно учитывается
+    // всегда). Переполнения не дают только остаток, частное с константным
+    // делителем, кроме -1, и степени 0 и 1
+    static bool mayFail(OpCode op, const TreeNode& right) {
+        bool constant = right.op == OpCode::PushConst;
+        switch (op) {
+            case OpCode::Div: return !constant || right.value == 0 || right.value == -1;
+            case OpCode::Mod: return !constant || right.value == 0;
+            case OpCode::Pow: return !constant || right.value < 0 || right.value > 1;
+            default: return true;
         }
-        if (node->value == "^") {
-            if (right < 0) throw ExpressionError("Отрицательная степень не поддерживается");
-            return static_cast<int>(std::pow(left, right));
+    }
+    
+    // Порядок операндов + и * после упрощения: константа слева, x справа
+    // (как после правила x*A → A*x), остальные поддеревья между ними
+    static int operandRank(const TreeNode& node) {
+        switch (node.op) {
+            case OpCode::PushConst: return 0;
+            case OpCode::PushX: return 2;
+            default: return 1;
         }
-        
-        throw ExpressionError("Неизвестный оператор: " + node->value);
     }
     
-    // Преобразует поддерево по правилу x*A → A*x
-    // Взято из решения DeepSeek
-    // Использует рекурсивный подход для обхода всего дерева
-    void transformNode(std::shared_ptr<TreeNode>& node) {
-        if (!node) return;
+    // Упрощает поддерево и возвращает номер его нового корня
+    // Поддерево из констант сворачивается в константу, применяются тождества
+    // A*1, 1*A, A+0, 0+A, A-0, A/1, A^1 → A, а A*0, 0*A, A%1 → 0 и
+    // A^0 → 1 - только если A не может дать ошибку (fallible[i] - может ли
+    // поддерево с корнем i дать ошибку). Операнды + и * упорядочиваются
+    // по operandRank, если ошибку может дать не больше одного из них: так
+    // первая ошибка при вычислении остается прежней. Двойное отрицание не
+    // сокращается: при насыщении -(-INT_MIN) равно -INT_MAX, а не INT_MIN.
+    // Узлы изменяются на месте, отброшенные поддеревья остаются в арене
+    // до compactNode
+    NodeIndex simplifyNode(NodeIndex index, std::vector<std::uint8_t>& fallible) {
+        TreeNode& node = nodes[index];
+        if (node.left == kNoNode) return index;
+        
+        node.left = simplifyNode(node.left, fallible);
+        if (node.right != kNoNode) node.right = simplifyNode(node.right, fallible);
+        NodeIndex left = node.left, right = node.right;
+        
+        auto isConstant = [&](NodeIndex i, int value) {
+            return nodes[i].op == OpCode::PushConst && nodes[i].value == value;
+        };
+        auto makeConstant = [&](int value) {
+            node = {OpCode::PushConst, value};
+            return index;
+        };
+        int result;
+        
+        if (node.op == OpCode::Neg) {
+            const TreeNode& operand = nodes[left];
+            if (operand.op == OpCode::PushConst && foldConstants(OpCode::Neg, operand.value, 0, result)) {
+                return makeConstant(result);
+            }
+            fallible[index] = true;
+            return index;
+        }
+        
+        if (nodes[left].op == OpCode::PushConst && nodes[right].op == OpCode::PushConst &&
+            foldConstants(node.op, nodes[left].value, nodes[right].value, result)) {
+            return makeConstant(result);
+        }
         
-        transformNode(node->left);
-        transformNode(node->right);
+        switch (node.op) {
+            case OpCode::Add:
+                if (isConstant(left, 0)) return right;
+                if (isConstant(right, 0)) return left;
+                break;
+            case OpCode::Sub:
+                if (isConstant(right, 0)) return left;
+                break;
+            case OpCode::Mul:
+                if (isConstant(left, 1)) return right;
+                if (isConstant(right, 1)) return left;
+                if ((isConstant(left, 0) && !fallible[right]) || (isConstant(right, 0) && !fallible[left])) {
+                    return makeConstant(0);
+                }
+                break;
+            case OpCode::Div:
+                if (isConstant(right, 1)) return left;
+                break;
+            case OpCode::Mod:
+                if (isConstant(right, 1) && !fallible[left]) return makeConstant(0);
+                break;
+            case OpCode::Pow:
+                if (isConstant(right, 1)) return left;
+                if (isConstant(right, 0) && !fallible[left]) return makeConstant(1);
+                break;
+            default:
+                break;
+        }
         
-        if (node->value == "*" && node->left && node->left->value == "x") {
-            std::swap(node->left, node->right);
+        fallible[index] = fallible[left] || fallible[right] || mayFail(node.op, nodes[right]);
+        if ((node.op == OpCode::Add || node.op == OpCode::Mul) &&
+            operandRank(nodes[left]) > operandRank(nodes[right]) && !(fallible[left] && fallible[right])) {
+            std::swap(node.left, node.right);
         }
+        return index;
+    }
+    
+    // Копирует поддерево в арену arena в постфиксном порядке и возвращает
+    // номер его корня в ней: в новую арену попадают только узлы дерева
+    NodeIndex compactNode(NodeIndex index, std::vector<TreeNode>& arena) {
+        TreeNode node = nodes[index];
+        if (node.left != kNoNode) node.left = compactNode(node.left, arena);
+        if (node.right != kNoNode) node.right = compactNode(node.right, arena);
+        return append(arena, node);
     }
     
     // Печатает поддерево в текстовом виде
     // Взято из решения DeepSeek
     // Использует отступы для визуального представления структуры дерева
-    void printNode(const std::shared_ptr<TreeNode>& node, int depth, std::ostream& out) {
-        if (!node) return;
+    void printNode(NodeIndex index, int depth, std::ostream& out) {
+        if (index == kNoNode) return;
+        const TreeNode& node = nodes[index];
         
-        printNode(node->right, depth + 1, out);
-        out << std::setw(depth * 4) << "" << node->value << "\n";
-        printNode(node->left, depth + 1, out);
+        printNode(node.right, depth + 1, out);
+        out << std::setw(depth * 4) << "" << label(node) << "\n";
+        printNode(node.left, depth + 1, out);
     }
     
 public:
     // Строит дерево из строкового выражения
     void buildFromExpression(const std::string& expr) {
-        auto tokens = tokenize(expr);
-        root = buildTreeFromTokens(tokens);
+        tokenize(expr);
+        // Дерево строится в запасной арене, которая затем меняется местами с
+        // текущей: при ошибке прежнее дерево не меняется, а повторные
+        // построения переиспользуют память обеих арен
+        NodeIndex top = buildTreeFromTokens(spare);
+        nodes.swap(spare);
+        root = top;
+        compile();
     }
     
     // Вычисляет значение выражения
+    // Дерево скомпилировано в байт-код при построении, поэтому повторные
+    // вычисления для разных x не обходят дерево
     int evaluate(int x) {
-        if (!root) throw ExpressionError("Пустое дерево выражений");
-        return evaluateNode(root, x);
+        if (root == kNoNode) throw ExpressionError("Пустое дерево выражений");
+        return withOverflowPolicy([&](auto policy) { return execute<decltype(policy)::value>(x); });
+    }
+    
+    // Задает обработку переполнения int при вычислении (по умолчанию
+    // OverflowPolicy::Throw - ошибка "Переполнение целого числа")
+    void setOverflowPolicy(OverflowPolicy policy) {
+        overflowPolicy = policy;
+    }
+    
+    // Вычисляет выражение для массива значений x: out[i] - результат для xs[i],
+    // status[i] - ошибка вычисления для xs[i] (Ok, если ее нет)
+    // Массив обрабатывается блоками по kBatchBlock значений, каждая инструкция
+    // байт-кода выполняется над всем блоком (см. executeBlock). При threads > 1
+    // блоки делятся на непрерывные части между потоками; у каждого потока свой
+    // стек блока. Исключение в потоке (например, нехватка памяти под стек
+    // блока) перехватывается, и после ожидания всех потоков бросается первое
+    // из них. Возвращает число значений x, на которых произошла ошибка
+    std::size_t evaluate(std::span<const int> xs, std::span<int> out, std::span<EvalStatus> status,
+                         unsigned threads = 1) {
+        if (root == kNoNode) throw ExpressionError("Пустое дерево выражений");
+        if (out.size() != xs.size() || status.size() != xs.size()) {
+            throw ExpressionError("Размеры массивов значений x и результатов не совпадают");
+        }
+        
+        std::size_t blocks = (xs.size() + kBatchBlock - 1) / kBatchBlock;
+        std::size_t workers = std::max<std::size_t>(1, std::min<std::size_t>(threads, blocks));
+        std::vector<std::size_t> failures(workers, 0);
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        auto fail = [&] {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+        };
+        auto work = [&](std::size_t worker) {
+            try {
+                BlockScratch scratch(stack.size());
+                std::size_t first = blocks * worker / workers * kBatchBlock;
+                std::size_t last = std::min(xs.size(), blocks * (worker + 1) / workers * kBatchBlock);
+                withOverflowPolicy([&](auto policy) {
+                    for (std::size_t begin = first; begin < last; begin += kBatchBlock) {
+                        std::size_t count = std::min(kBatchBlock, last - begin);
+                        executeBlock<decltype(policy)::value>(xs.data() + begin, out.data() + begin,
+                                                              status.data() + begin, count, scratch);
+                        failures[worker] += static_cast<std::size_t>(
+                            std::count_if(status.begin() + begin, status.begin() + begin + count,
+                                          [](EvalStatus s) { return s != EvalStatus::Ok; }));
+                    }
+                });
+            } catch (...) {
+                fail();
+            }
+        };
+        
+        // Если поток не удалось создать, своя часть не вычисляется, но уже
+        // запущенные потоки дожидаются: иначе деструктор std::thread вызвал бы terminate
+        std::vector<std::thread> pool;
+        bool started = true;
+        try {
+            for (std::size_t worker = 1; worker < workers; ++worker) {
+                pool.emplace_back(work, worker);
+            }
+        } catch (...) {
+            fail();
+            started = false;
+        }
+        if (started) work(0);
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+        if (error) std::rethrow_exception(error);
+        return std::accumulate(failures.begin(), failures.end(), std::size_t{0});
+    }
+    
+    // Вычисляет выражение для массива значений x без массива ошибок:
+    // ошибка для первого по порядку x, на котором она произошла,
+    // бросается как ExpressionError
+    void evaluate(std::span<const int> xs, std::span<int> out, unsigned threads = 1) {
+        std::vector<EvalStatus> status(xs.size());
+        if (evaluate(xs, out, status, threads) != 0) {
+            auto failed = std::find_if(status.begin(), status.end(), [](EvalStatus s) { return s != EvalStatus::Ok; });
+            throw ExpressionError(describe(*failed));
+        }
     }
     
     // Преобразует дерево по правилу x*A → A*x
+    // Байт-код компилируется заново, чтобы соответствовать новому дереву
     void transform() {
-        if (!root) throw ExpressionError("Пустое дерево выражений");
+        if (root == kNoNode) throw ExpressionError("Пустое дерево выражений");
         transformNode(root);
+        compile();
+    }
+    
+    // Упрощает дерево (см. simplifyNode) и сжимает арену до узлов нового
+    // дерева
+    // Результат вычисления для любого x, включая ошибки, не меняется, а
+    // поддеревья без x больше не вычисляются при каждом вызове evaluate.
+    // Байт-код компилируется заново, упрощенное дерево печатается print
+    void simplify() {
+        if (root == kNoNode) throw ExpressionError("Пустое дерево выражений");
+        std::vector<std::uint8_t> fallible(nodes.size(), 0);
+        NodeIndex top = simplifyNode(root, fallible);
+        spare.clear();
+        spare.reserve(nodes.size());
+        root = compactNode(top, spare);
+        nodes.swap(spare);
+        compile();
     }
     
     // Печатает дерево в текстовом виде
     void print(std::ostream& out) {
-        if (!root) throw ExpressionError("Пустое дерево выражений");
+        if (root == kNoNode) throw ExpressionError("Пустое дерево выражений");
         printNode(root, 0, out);
     }
 };
@@ -0,0 +1,460 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <unordered_set>
+#include <utility>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Бенчмарк реализаций калькулятора степеней графа
+// Сборка: g++ -std=c++20 -O2 benchmark.cpp -o benchmark (только POSIX: posix_spawn/wait4)
+//
+// Генерирует графы нескольких семейств и размеров, запускает каждую реализацию
+// отдельным процессом и измеряет время работы и пиковую память (ru_maxrss).
+// Время этапов (--timings) сообщает только оптимизированное решение; у
+// остальных реализаций и при неудачном запуске поле "phases" равно null.
+// Результаты выводятся в формате JSON.
+//
+// Параметры:
+// --optimized PATH - исполняемый файл optimized_solution.cpp;
+// --binary NAME=PATH - другая реализация (deepseek, gpt, mistral); она
+//   запускается в рабочем каталоге, где входной граф лежит под именами
+//   FN1.txt, input.txt и FileName.txt, которые читают разные решения;
+// --sizes 10,100,... - числа вершин (по умолчанию 10, 100, ..., 10^6);
+// --families er,powerlaw,regular,dense,empty - семейства графов;
+// --max-matrix N - наибольший граф, записываемый матрицей смежности
+//   (по умолчанию 4000); большие графы записываются списком ребер и
+//   запускаются только на оптимизированном решении;
+// --repeat R - число повторов (берется наименьшее время);
+// --workdir DIR - каталог для входных и выходных файлов;
+// --output FILE - файл JSON (по умолчанию stdout);
+// --seed S - начальное значение генератора.
+
+// Класс исключения для ошибок бенчмарка
+class BenchmarkError : public std::runtime_error {
+public:
+    BenchmarkError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+// Неориентированный граф без петель и повторных ребер (вершины с 0)
+struct EdgeList {
+    int vertices = 0;
+    std::vector<std::pair<int, int>> edges;
+};
+
+// Генераторы синтетических графов; графы воспроизводимы по seed
+class GraphGenerator {
+public:
+    explicit GraphGenerator(std::uint64_t seed) : random(seed) {}
+
+    EdgeList generate(const std::string& family, int n) {
+        if (family == "er") return erdosRenyi(n, 8.0);
+        if (family == "powerlaw") return preferentialAttachment(n, 4);
+        if (family == "regular") return ringLattice(n, 8);
+        if (family == "dense") return erdosRenyi(n, (n - 1) / 2.0);
+        if (family == "empty") return EdgeList{n, {}};
+        throw BenchmarkError("Неизвестное семейство графов: " + family);
+    }
+
+    // Плотные графы записываются только матрицей
+    static bool isDense(const std::string& family) { return family == "dense"; }
+
+private:
+    // Граф Эрдеша - Реньи G(n, m) со средней степенью averageDegree
+    EdgeList erdosRenyi(int n, double averageDegree) {
+        EdgeList graph{n, {}};
+        std::uint64_t pairs = static_cast<std::uint64_t>(n) * (n - 1) / 2;
+        auto m = std::min<std::uint64_t>(pairs, static_cast<std::uint64_t>(n * averageDegree / 2));
+        std::uniform_int_distribution<int> vertex(0, std::max(0, n - 1));
+        std::unordered_set<std::uint64_t> seen;
+        seen.reserve(m * 2);
+        while (graph.edges.size() < m) {
+            int u = vertex(random), v = vertex(random);
+            if (u == v) continue;
+            if (u > v) std::swap(u, v);
+            if (seen.insert(key(u, v)).second) {
+                graph.edges.emplace_back(u, v);
+            }
+        }
+        return graph;
+    }
+
+    // Модель Барабаши - Альберт: каждая новая вершина соединяется с links
+    // вершинами, выбранными пропорционально степени (степенной закон)
+    EdgeList preferentialAttachment(int n, int links) {
+        EdgeList graph{n, {}};
+        std::vector<int> endpoints;
+        int core = std::min(n, links + 1);
+        for (int u = 0; u < core; ++u) {
+            for (int v = u + 1; v < core; ++v) {
+                graph.edges.emplace_back(u, v);
+                endpoints.push_back(u);
+                endpoints.push_back(v);
+            }
+        }
+        std::vector<int> targets;
+        for (int u = core; u < n; ++u) {
+            targets.clear();
+            std::uniform_int_distribution<std::size_t> pick(0, endpoints.size() - 1);
+            while (static_cast<int>(targets.size()) < links) {
+                int v = endpoints[pick(random)];
+                if (std::find(targets.begin(), targets.end(), v) == targets.end()) {
+                    targets.push_back(v);
+                }
+            }
+            for (int v : targets) {
+                graph.edges.emplace_back(v, u);
+                endpoints.push_back(u);
+                endpoints.push_back(v);
+            }
+        }
+        return graph;
+    }
+
+    // Кольцевая решетка: вершина соединена с degree / 2 соседями с каждой
+    // стороны (регулярный граф степени degree при n > degree)
+    EdgeList ringLattice(int n, int degree) {
+        EdgeList graph{n, {}};
+        int reach = std::min(degree / 2, (n - 1) / 2);
+        for (int u = 0; u < n; ++u) {
+            for (int k = 1; k <= reach; ++k) {
+                int v = (u + k) % n;
+                graph.edges.emplace_back(std::min(u, v), std::max(u, v));
+            }
+        }
+        return graph;
+    }
+
+    static std::uint64_t key(int u, int v) {
+        return (static_cast<std::uint64_t>(u) << 32) | static_cast<std::uint32_t>(v);
+    }
+
+    std::mt19937_64 random;
+};
+
+// Записывает граф матрицей смежности (формат FN1.txt)
+void writeMatrix(const EdgeList& graph, const std::string& filename) {
+    int n = graph.vertices;
+    std::vector<std::string> rows(n, std::string(2 * static_cast<std::size_t>(n), ' '));
+    for (auto& row : rows) {
+        for (int j = 0; j < n; ++j) row[2 * j] = '0';
+        row.back() = '\n';
+    }
+    for (auto [u, v] : graph.edges) {
+        rows[u][2 * v] = '1';
+        rows[v][2 * u] = '1';
+    }
+    std::ofstream fout(filename, std::ios::binary);
+    fout << n << "\n";
+    for (const auto& row : rows) {
+        fout << row;
+    }
+    if (!fout) {
+        throw BenchmarkError("Ошибка записи в файл: " + filename);
+    }
+}
+
+// Записывает граф списком ребер "n m" и m строк "u v" (вершины с 1)
+void writeEdgeList(const EdgeList& graph, const std::string& filename) {
+    std::ofstream fout(filename, std::ios::binary);
+    fout << graph.vertices << " " << graph.edges.size() << "\n";
+    for (auto [u, v] : graph.edges) {
+        fout << (u + 1) << " " << (v + 1) << "\n";
+    }
+    if (!fout) {
+        throw BenchmarkError("Ошибка записи в файл: " + filename);
+    }
+}
+
+// Итог одного запуска процесса
+struct RunResult {
+    int exitCode = -1;
+    double seconds = 0;
+    long peakRssKb = 0;
+    std::string stderrText;
+};
+
+// Генерирует граф и записывает его в directory/FN1.txt (и копии для других
+// решений) в отдельном процессе; возвращает число ребер.
+// Linux переносит пиковую память процесса через exec в ru_maxrss потомка,
+// поэтому сам бенчмарк должен оставаться маленьким: большие графы строятся
+// и освобождаются в дочернем процессе, который затем завершается
+std::uint64_t prepareInput(const std::string& family, int n, bool matrix, std::uint64_t seed,
+                           const std::string& directory) {
+    std::string countFile = directory + "/edges.txt";
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw BenchmarkError("Не удалось создать процесс");
+    }
+    if (pid == 0) {
+        try {
+            GraphGenerator generator(seed);
+            EdgeList graph = generator.generate(family, n);
+            std::string input = directory + "/FN1.txt";
+            if (matrix) {
+                writeMatrix(graph, input);
+                // Другие решения читают входной файл под своими именами
+                for (const char* alias : {"input.txt", "FileName.txt"}) {
+                    std::filesystem::copy_file(input, directory + "/" + alias,
+                                               std::filesystem::copy_options::overwrite_existing);
+                }
+            } else {
+                writeEdgeList(graph, input);
+            }
+            std::ofstream(countFile) << graph.edges.size() << "\n";
+            std::cout.flush();
+            _exit(0);
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка: " << e.what() << std::endl;
+            _exit(1);
+        }
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw BenchmarkError("Не удалось сгенерировать граф " + family + " на " + std::to_string(n) + " вершин");
+    }
+    std::uint64_t edges = 0;
+    std::ifstream(countFile) >> edges;
+    return edges;
+}
+
+// Запускает программу в каталоге directory, stdin читается из /dev/null
+// (решения, ждущие ввода с клавиатуры, не зависают), stdout отбрасывается,
+// stderr сохраняется. Пиковая память дочернего процесса берется из wait4
+RunResult runProcess(const std::vector<std::string>& command, const std::string& directory) {
+    std::string errorFile = directory + "/stderr.txt";
+    posix_spawn_file_actions_t actions;
+    if (posix_spawn_file_actions_init(&actions) != 0) {
+        throw BenchmarkError("Не удалось подготовить запуск " + command[0]);
+    }
+    // Без каталога или перенаправлений процесс работал бы не с теми файлами,
+    // а его время и память все равно попали бы в результаты
+    int prepared = posix_spawn_file_actions_addchdir_np(&actions, directory.c_str());
+    if (prepared == 0) {
+        prepared = posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    }
+    if (prepared == 0) {
+        prepared = posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    }
+    if (prepared == 0) {
+        prepared = posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, errorFile.c_str(),
+                                                    O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (prepared != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        throw BenchmarkError("Не удалось подготовить запуск " + command[0] + " в каталоге " + directory);
+    }
+    std::vector<char*> argv;
+    for (const auto& arg : command) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    int spawned = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (spawned != 0) {
+        throw BenchmarkError("Не удалось запустить " + command[0]);
+    }
+
+    RunResult result;
+    int status = 0;
+    rusage usage{};
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        throw BenchmarkError("Ошибка ожидания процесса");
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    result.peakRssKb = usage.ru_maxrss;
+    std::ifstream fin(errorFile);
+    std::stringstream text;
+    text << fin.rdbuf();
+    result.stderrText = text.str();
+    return result;
+}
+
+// Извлекает время этапов из строки "timings: parse=... validate=... ..."
+std::vector<std::pair<std::string, double>> parseTimings(const std::string& text) {
+    std::vector<std::pair<std::string, double>> phases;
+    std::size_t line = text.find("timings:");
+    if (line == std::string::npos) {
+        return phases;
+    }
+    std::istringstream in(text.substr(line + 8, text.find('\n', line) - line - 8));
+    std::string item;
+    while (in >> item) {
+        std::size_t eq = item.find('=');
+        if (eq != std::string::npos) {
+            phases.emplace_back(item.substr(0, eq), std::strtod(item.c_str() + eq + 1, nullptr));
+        }
+    }
+    return phases;
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// Реализация для сравнения
+struct Implementation {
+    std::string name;
+    std::string path;
+    bool optimized = false;  // Поддерживает --input/--output/--timings и списки ребер
+};
+
+int main(int argc, char* argv[]) {
+    try {
+        std::vector<Implementation> implementations;
+        std::vector<int> sizes = {10, 100, 1000, 10000, 100000, 1000000};
+        std::vector<std::string> families = {"er", "powerlaw", "regular", "dense", "empty"};
+        int maxMatrix = 4000;
+        int repeat = 1;
+        std::string workdir = "benchmark_work";
+        std::string output;
+        std::uint64_t seed = 1;
+        for (int k = 1; k < argc; ++k) {
+            std::string arg = argv[k];
+            if (arg == "--optimized" && k + 1 < argc) {
+                implementations.push_back({"optimized", argv[++k], true});
+            } else if (arg == "--binary" && k + 1 < argc) {
+                std::string spec = argv[++k];
+                std::size_t eq = spec.find('=');
+                if (eq == std::string::npos) {
+                    throw BenchmarkError("Ожидается --binary NAME=PATH: " + spec);
+                }
+                implementations.push_back({spec.substr(0, eq), spec.substr(eq + 1), false});
+            } else if (arg == "--sizes" && k + 1 < argc) {
+                sizes.clear();
+                for (const auto& item : splitList(argv[++k])) sizes.push_back(std::stoi(item));
+            } else if (arg == "--families" && k + 1 < argc) {
+                families = splitList(argv[++k]);
+            } else if (arg == "--max-matrix" && k + 1 < argc) {
+                maxMatrix = std::stoi(argv[++k]);
+            } else if (arg == "--repeat" && k + 1 < argc) {
+                repeat = std::max(1, std::stoi(argv[++k]));
+            } else if (arg == "--workdir" && k + 1 < argc) {
+                workdir = argv[++k];
+            } else if (arg == "--output" && k + 1 < argc) {
+                output = argv[++k];
+            } else if (arg == "--seed" && k + 1 < argc) {
+                seed = std::stoull(argv[++k]);
+            } else {
+                throw BenchmarkError("Неизвестный параметр: " + arg);
+            }
+        }
+        if (implementations.empty()) {
+            throw BenchmarkError("Не задано ни одной реализации (--optimized или --binary)");
+        }
+        for (auto& impl : implementations) {
+            impl.path = std::filesystem::absolute(impl.path).string();
+        }
+        std::filesystem::create_directories(workdir);
+        workdir = std::filesystem::absolute(workdir).string();
+
+        std::ostringstream json;
+        json << "{\n  \"results\": [";
+        bool first = true;
+        for (const auto& family : families) {
+            for (int n : sizes) {
+                bool matrix = n <= maxMatrix;
+                if (GraphGenerator::isDense(family) && !matrix) {
+                    continue;
+                }
+                std::cerr << "Граф " << family << ", " << n << " вершин\n";
+                std::uint64_t edges = prepareInput(family, n, matrix, seed++, workdir);
+
+                for (const auto& impl : implementations) {
+                    if (!matrix && !impl.optimized) {
+                        continue;
+                    }
+                    std::vector<std::string> command = {impl.path};
+                    if (impl.optimized) {
+                        command.insert(command.end(), {"--input", "FN1.txt", "--output", "FN2.txt", "--timings"});
+                    }
+                    RunResult best;
+                    for (int r = 0; r < repeat; ++r) {
+                        RunResult run = runProcess(command, workdir);
+                        if (r == 0 || run.seconds < best.seconds) {
+                            long rss = std::max(best.peakRssKb, run.peakRssKb);
+                            best = run;
+                            best.peakRssKb = rss;
+                        }
+                    }
+
+                    double edgesPerSecond = best.seconds > 0 ? edges / best.seconds : 0;
+                    json << (first ? "\n" : ",\n") << "    {\"implementation\": \"" << jsonEscape(impl.name)
+                         << "\", \"family\": \"" << family << "\", \"vertices\": " << n
+                         << ", \"edges\": " << edges
+                         << ", \"input\": \"" << (matrix ? "matrix" : "edges") << "\""
+                         << ", \"exit_code\": " << best.exitCode
+                         << ", \"seconds\": " << best.seconds
+                         << ", \"edges_per_second\": " << edgesPerSecond
+                         << ", \"peak_rss_kb\": " << best.peakRssKb;
+                    auto phases = parseTimings(best.stderrText);
+                    if (phases.empty()) {
+                        json << ", \"phases\": null";
+                    } else {
+                        json << ", \"phases\": {";
+                        for (std::size_t p = 0; p < phases.size(); ++p) {
+                            json << (p ? ", " : "") << "\"" << phases[p].first << "\": " << phases[p].second;
+                        }
+                        json << "}";
+                    }
+                    if (best.exitCode != 0) {
+                        json << ", \"error\": \"" << jsonEscape(best.stderrText) << "\"";
+                    }
+                    json << "}";
+                    first = false;
+                }
+            }
+        }
+        json << "\n  ]\n}\n";
+
+        if (output.empty()) {
+            std::cout << json.str();
+        } else {
+            std::ofstream fout(output);
+            fout << json.str();
+            if (!fout) {
+                throw BenchmarkError("Ошибка записи в файл: " + output);
+            }
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+} 
\ No newline at end of file
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @file graph_view.hpp
+ * @brief Встраиваемый интерфейс калькулятора степеней графа без копирования данных
+ * @details Представления (view) строятся поверх буферов вызывающего кода:
+ * матрицы смежности из элементов любого числового типа, упакованной битовой
+ * матрицы и массивов CSR. Представления не владеют данными и не выделяют
+ * память; буфер должен жить дольше представления. Функции не бросают
+ * исключений и возвращают Result с кодом ошибки и номером вершины.
+ *
+ * Пример:
+ *   graph_view::MatrixView<std::uint8_t> view(cells, n);
+ *   if (auto result = graph_view::validate(view); !result) { ... }
+ *   graph_view::calculateDegrees(view, degrees);
+ */
+
+namespace graph_view {
+
+// Код результата операции
+enum class Status {
+    Ok,
+    EmptyGraph,        // Граф без вершин
+    BufferTooSmall,    // Входной буфер короче, чем требуют размеры представления
+    OutputTooSmall,    // Выходной буфер короче числа вершин
+    InvalidValue,      // Элемент матрицы не равен 0 или 1
+    SelfLoop,          // Ненулевой элемент на главной диагонали (петля)
+    NotSymmetric,      // Матрица несимметрична или ребро есть только в одном списке
+    VertexOutOfRange,  // Номер соседа в CSR вне диапазона 0..n-1
+    BadOffsets,        // Смещения CSR убывают
+    DuplicateEdge      // Повторное ребро или неотсортированный список соседей
+};
+
+// Результат операции: код и вершина (строка матрицы), в которой найдена ошибка
+struct Result {
+    Status status = Status::Ok;
+    int vertex = -1;
+
+    constexpr bool ok() const noexcept { return status == Status::Ok; }
+    constexpr explicit operator bool() const noexcept { return ok(); }
+};
+
+// Текст ошибки (совпадает с сообщениями optimized_solution.cpp)
+constexpr std::string_view describe(Status status) noexcept {
+    switch (status) {
+        case Status::Ok: return "Успешно";
+        case Status::EmptyGraph: return "Пустая матрица смежности";
+        case Status::BufferTooSmall: return "Размер буфера меньше размера графа";
+        case Status::OutputTooSmall: return "Размер вектора степеней не соответствует количеству вершин";
+        case Status::InvalidValue: return "Матрица смежности должна содержать только 0 и 1";
+        case Status::SelfLoop: return "На главной диагонали должны быть нули";
+        case Status::NotSymmetric: return "Матрица смежности должна быть симметричной";
+        case Status::VertexOutOfRange: return "Недопустимый номер вершины в списке смежности";
+        case Status::BadOffsets: return "Некорректные смещения списков смежности";
+        case Status::DuplicateEdge: return "Список ребер содержит повторные ребра";
+    }
+    return "Неизвестная ошибка";
+}
+
+// Транспонирует блок 64 x 64 бита на месте: бит c слова r переходит в бит r слова c
+// Рекурсивный обмен полублоков (32, 16, ..., 1) за 6 проходов по 32 пары слов
+inline void transposeTile(std::uint64_t* tile) noexcept {
+    std::uint64_t mask = 0x00000000ffffffffULL;
+    for (int width = 32; width != 0; width >>= 1, mask ^= (mask << width)) {
+        for (int k = 0; k < 64; k = ((k | width) + 1) & ~width) {
+            std::uint64_t t = ((tile[k] >> width) ^ tile[k | width]) & mask;
+            tile[k] ^= t << width;
+            tile[k | width] ^= t;
+        }
+    }
+}
+
+// Матрица смежности n x n из элементов T, построчно с шагом stride элементов
+// Подходит для массивов int, char, uint8_t или bool, заполненных 0 и 1
+template <typename T>
+class MatrixView {
+    static_assert(std::is_arithmetic_v<T>, "Элемент матрицы должен быть числом");
+
+public:
+    constexpr MatrixView(std::span<const T> cells, int n) noexcept : MatrixView(cells, n, n) {}
+    constexpr MatrixView(std::span<const T> cells, int n, std::size_t stride) noexcept
+        : cells(cells), n(n), stride(stride) {}
+
+    constexpr int dimension() const noexcept { return n; }
+    constexpr std::span<const T> row(int i) const noexcept {
+        return cells.subspan(static_cast<std::size_t>(i) * stride, static_cast<std::size_t>(n));
+    }
+    constexpr T at(int i, int j) const noexcept { return cells[static_cast<std::size_t>(i) * stride + j]; }
+
+    // Проверяет, что буфер вмещает все строки
+    constexpr Result checkShape() const noexcept {
+        if (n <= 0) return {Status::EmptyGraph};
+        if (stride < static_cast<std::size_t>(n) ||
+            cells.size() < (static_cast<std::size_t>(n) - 1) * stride + n) {
+            return {Status::BufferTooSmall};
+        }
+        return {};
+    }
+
+private:
+    std::span<const T> cells;
+    int n;
+    std::size_t stride;
+};
+
+// Упакованная битовая матрица: бит j слова j / 64 строки i - ребро (i, j)
+// Строки идут с шагом stride слов (не меньше (n + 63) / 64). Биты за
+// пределами n в последнем слове строки игнорируются. Выравнивание не требуется
+class BitmapView {
+public:
+    constexpr BitmapView(std::span<const std::uint64_t> words, int n) noexcept
+        : BitmapView(words, n, (static_cast<std::size_t>(n) + 63) / 64) {}
+    constexpr BitmapView(std::span<const std::uint64_t> words, int n, std::size_t stride) noexcept
+        : words(words), n(n), stride(stride) {}
+
+    constexpr int dimension() const noexcept { return n; }
+    constexpr std::size_t wordsPerRow() const noexcept { return (static_cast<std::size_t>(n) + 63) / 64; }
+    constexpr const std::uint64_t* row(int i) const noexcept {
+        return words.data() + static_cast<std::size_t>(i) * stride;
+    }
+
+    // Маска значимых битов слова w строки
+    constexpr std::uint64_t mask(std::size_t w) const noexcept {
+        std::size_t tail = static_cast<std::size_t>(n) - 64 * w;
+        return tail >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << tail) - 1;
+    }
+
+    // Проверяет, что буфер вмещает все строки
+    constexpr Result checkShape() const noexcept {
+        if (n <= 0) return {Status::EmptyGraph};
+        if (stride < wordsPerRow() ||
+            words.size() < (static_cast<std::size_t>(n) - 1) * stride + wordsPerRow()) {
+            return {Status::BufferTooSmall};
+        }
+        return {};
+    }
+
+    // Копирует блок 64 x 64 (блочная строка I, слово J) в tile, дополняя нулями
+    void loadTile(int tileRow, int tileColumn, std::uint64_t* tile) const noexcept {
+        std::uint64_t m = mask(tileColumn);
+        for (int k = 0; k < 64; ++k) {
+            int r = tileRow * 64 + k;
+            tile[k] = r < n ? row(r)[tileColumn] & m : 0;
+        }
+    }
+
+private:
+    std::span<const std::uint64_t> words;
+    int n;
+    std::size_t stride;
+};
+
+// Списки смежности в формате CSR: соседи вершины i - neighbors[offsets[i]..offsets[i + 1])
+// Для неориентированного графа каждое ребро должно быть в списках обоих концов
+template <typename Offset = std::size_t, typename Index = int>
+class CsrView {
+    static_assert(std::is_integral_v<Offset> && std::is_integral_v<Index>,
+                  "Смещения и номера вершин должны быть целыми");
+
+public:
+    constexpr CsrView(std::span<const Offset> offsets, std::span<const Index> neighbors) noexcept
+        : offsets(offsets), neighbors(neighbors) {}
+
+    constexpr int dimension() const noexcept {
+        return offsets.empty() ? 0 : static_cast<int>(offsets.size() - 1);
+    }
+    constexpr std::span<const Index> row(int i) const noexcept {
+        return neighbors.subspan(static_cast<std::size_t>(offsets[i]),
+                                 static_cast<std::size_t>(offsets[i + 1] - offsets[i]));
+    }
+    constexpr std::size_t degree(int i) const noexcept {
+        return static_cast<std::size_t>(offsets[i + 1] - offsets[i]);
+    }
+
+    // Проверяет смещения: они не убывают и не выходят за массив соседей
+    constexpr Result checkShape() const noexcept {
+        if (dimension() <= 0) return {Status::EmptyGraph};
+        if constexpr (std::is_signed_v<Offset>) {
+            if (offsets[0] < 0) return {Status::BadOffsets, 0};
+        }
+        for (int i = 0; i < dimension(); ++i) {
+            if (offsets[i + 1] < offsets[i]) return {Status::BadOffsets, i};
+        }
+        if (static_cast<std::size_t>(offsets.back()) > neighbors.size()) return {Status::BufferTooSmall};
+        return {};
+    }
+
+private:
+    std::span<const Offset> offsets;
+    std::span<const Index> neighbors;
+};
+
+// Проверяет матрицу неориентированного графа: только 0 и 1, нули на диагонали,
+// симметричность. Обход блоками 64 x 64 верхнего треугольника: элемент (j, i)
+// читается из того же блока, что и (i, j) после транспонирования, поэтому обход
+// по столбцам остается в кэше. Сообщается ошибка в наименьшей строке (диагональ
+// строки проверяется раньше симметричности), как при последовательном обходе
+template <typename T>
+Result validate(const MatrixView<T>& view) noexcept {
+    if (Result shape = view.checkShape(); !shape) return shape;
+    int n = view.dimension();
+    for (int base = 0; base < n; base += 64) {
+        int end = std::min(n, base + 64);
+        long long first = LLONG_MAX;  // 3 * строка + вид ошибки
+        auto report = [&](int i, int kind) { first = std::min(first, 3LL * i + kind); };
+        for (int i = base; i < end; ++i) {
+            for (T value : view.row(i)) {
+                if (value != T{0} && value != T{1}) {
+                    report(i, 0);
+                    break;
+                }
+            }
+            if (view.at(i, i) != T{0}) report(i, 1);
+        }
+        for (int tile = base; tile < n; tile += 64) {
+            int tileEnd = std::min(n, tile + 64);
+            for (int i = base; i < end && 3LL * i + 2 < first; ++i) {
+                for (int j = std::max(tile, i + 1); j < tileEnd; ++j) {
+                    if (view.at(i, j) != view.at(j, i)) {
+                        report(i, 2);
+                        break;
+                    }
+                }
+            }
+        }
+        if (first != LLONG_MAX) {
+            constexpr Status kinds[] = {Status::InvalidValue, Status::SelfLoop, Status::NotSymmetric};
+            return {kinds[first % 3], static_cast<int>(first / 3)};
+        }
+    }
+    return {};
+}
+
+// Проверяет битовую матрицу: нули на диагонали и симметричность
+// Блок (I, J) верхнего треугольника сравнивается с транспонированным блоком (J, I)
+inline Result validate(const BitmapView& view) noexcept {
+    if (Result shape = view.checkShape(); !shape) return shape;
+    int tiles = static_cast<int>(view.wordsPerRow());
+    alignas(64) std::uint64_t upper[64];
+    alignas(64) std::uint64_t lower[64];
+    for (int tileRow = 0; tileRow < tiles; ++tileRow) {
+        long long first = LLONG_MAX;  // 2 * строка (+1 для несимметричности)
+        for (int tileColumn = tileRow; tileColumn < tiles; ++tileColumn) {
+            view.loadTile(tileRow, tileColumn, upper);
+            if (tileColumn == tileRow) {
+                std::copy(upper, upper + 64, lower);
+            } else {
+                view.loadTile(tileColumn, tileRow, lower);
+            }
+            transposeTile(lower);
+            for (int k = 0; k < 64; ++k) {
+                long long row = 64LL * tileRow + k;
+                if (tileColumn == tileRow && ((upper[k] >> k) & 1)) {
+                    first = std::min(first, 2 * row);
+                    break;
+                }
+                if (upper[k] != lower[k]) {
+                    first = std::min(first, 2 * row + 1);
+                    break;
+                }
+            }
+        }
+        if (first != LLONG_MAX) {
+            return {first % 2 == 0 ? Status::SelfLoop : Status::NotSymmetric, static_cast<int>(first / 2)};
+        }
+    }
+    return {};
+}
+
+// Проверяет CSR неориентированного графа: номера в диапазоне, без петель,
+// списки отсортированы без повторов, каждое ребро (u, v) есть и в списке v
+// (двоичный поиск, O(m log d))
+template <typename Offset, typename Index>
+Result validate(const CsrView<Offset, Index>& view) noexcept {
+    if (Result shape = view.checkShape(); !shape) return shape;
+    int n = view.dimension();
+    for (int u = 0; u < n; ++u) {
+        std::span<const Index> list = view.row(u);
+        for (std::size_t k = 0; k < list.size(); ++k) {
+            Index v = list[k];
+            if (static_cast<std::make_unsigned_t<Index>>(v) >= static_cast<unsigned>(n)) {
+                return {Status::VertexOutOfRange, u};
+            }
+            if (v == u) return {Status::SelfLoop, u};
+            if (k > 0 && list[k - 1] >= v) return {Status::DuplicateEdge, u};
+        }
+    }
+    for (int u = 0; u < n; ++u) {
+        for (Index v : view.row(u)) {
+            std::span<const Index> back = view.row(static_cast<int>(v));
+            if (!std::binary_search(back.begin(), back.end(), static_cast<Index>(u))) {
+                return {Status::NotSymmetric, u};
+            }
+        }
+    }
+    return {};
+}
+
+// Степени вершин: число ненулевых элементов строки
+// Данные не проверяются (для этого есть validate); проверяются только размеры
+template <typename T>
+Result calculateDegrees(const MatrixView<T>& view, std::span<int> out) noexcept {
+    if (Result shape = view.checkShape(); !shape) return shape;
+    int n = view.dimension();
+    if (out.size() < static_cast<std::size_t>(n)) return {Status::OutputTooSmall};
+    for (int i = 0; i < n; ++i) {
+        int degree = 0;
+        for (T value : view.row(i)) {
+            degree += value != T{0};
+        }
+        out[i] = degree;
+    }
+    return {};
+}
+
+// Степени вершин битовой матрицы: popcount слов строки
+inline Result calculateDegrees(const BitmapView& view, std::span<int> out) noexcept {
+    if (Result shape = view.checkShape(); !shape) return shape;
+    int n = view.dimension();
+    if (out.size() < static_cast<std::size_t>(n)) return {Status::OutputTooSmall};
+    std::size_t words = view.wordsPerRow();
+    std::uint64_t tail = view.mask(words - 1);
+    for (int i = 0; i < n; ++i) {
+        const std::uint64_t* row = view.row(i);
+        int degree = std::popcount(row[words - 1] & tail);
+        for (std::size_t w = 0; w + 1 < words; ++w) {
+            degree += std::popcount(row[w]);
+        }
+        out[i] = degree;
+    }
+    return {};
+}
+
+// Степени вершин CSR: длины списков, O(n) без чтения массива соседей
+template <typename Offset, typename Index>
+Result calculateDegrees(const CsrView<Offset, Index>& view, std::span<int> out) noexcept {
+    if (Result shape = view.checkShape(); !shape) return shape;
+    int n = view.dimension();
+    if (out.size() < static_cast<std::size_t>(n)) return {Status::OutputTooSmall};
+    for (int i = 0; i < n; ++i) {
+        out[i] = static_cast<int>(view.degree(i));
+    }
+    return {};
+}
+
+}  // namespace graph_view
\ No newline at end of file
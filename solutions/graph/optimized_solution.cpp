@@ -5,174 +5,3436 @@
 #include <sstream>
 #include <stdexcept>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GRAPH_HAS_MMAP 1
+#endif
+
+#if defined(__SSE2__) || defined(__AVX2__) || defined(__AVX512VPOPCNTDQ__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "graph_view.hpp"
 
 /**
  * @file optimized_solution.cpp
  * @brief Оптимизированная реализация калькулятора степеней графа
  * @details Объединяет лучшие аспекты решений DeepSeek, Mistral и GPT-4o
+ *
+ * Сборка: g++ -std=c++20 -O2 -march=native optimized_solution.cpp
+ * (-march=native включает POPCNT/AVX2/AVX-512, если они есть у процессора)
  */
 
-// Класс исключения для обработки ошибок в работе с графом
-// Взято из решения DeepSeek для улучшения обработки ошибок
-class GraphError : public std::runtime_error {
-public:
-    // Создает новый объект исключения с указанным сообщением
-    GraphError(const std::string& msg) : std::runtime_error(msg) {}
-};
+// Класс исключения для обработки ошибок в работе с графом
+// Взято из решения DeepSeek для улучшения обработки ошибок
+class GraphError : public std::runtime_error {
+public:
+    // Создает новый объект исключения с указанным сообщением
+    GraphError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+// Подсчитывает количество единичных битов в массиве 64-битных слов
+// Массив должен быть выровнен по 64 байта, а его длина кратна 8 словам
+// (это гарантирует BitMatrix), поэтому векторные циклы обходятся без хвоста
+inline std::size_t countBits(const std::uint64_t* words, std::size_t count) {
+#if defined(__AVX512VPOPCNTDQ__) && defined(__AVX512F__)
+    // AVX-512: аппаратный popcount сразу по восьми словам
+    __m512i acc = _mm512_setzero_si512();
+    for (std::size_t k = 0; k < count; k += 8) {
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_load_si512(words + k)));
+    }
+    return static_cast<std::size_t>(_mm512_reduce_add_epi64(acc));
+#elif defined(__AVX2__)
+    // AVX2: подсчет по таблице тетрад (алгоритм Мулы) и суммирование через vpsadbw
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0f);
+    __m256i acc = _mm256_setzero_si256();
+    for (std::size_t k = 0; k < count; k += 4) {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(words + k));
+        __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, lowMask));
+        __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+    }
+    return static_cast<std::size_t>(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+                                     _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+#else
+    // Скалярный вариант: std::popcount компилируется в инструкцию popcnt
+    std::size_t total = 0;
+    for (std::size_t k = 0; k < count; ++k) {
+        total += std::popcount(words[k]);
+    }
+    return total;
+#endif
+}
+
+// Подсчитывает количество общих единичных битов двух массивов (popcount(a & b))
+// Требования к выравниванию и длине те же, что у countBits. Для строк матрицы
+// смежности это число общих соседей двух вершин
+inline std::size_t countCommonBits(const std::uint64_t* a, const std::uint64_t* b, std::size_t count) {
+#if defined(__AVX512VPOPCNTDQ__) && defined(__AVX512F__)
+    __m512i acc = _mm512_setzero_si512();
+    for (std::size_t k = 0; k < count; k += 8) {
+        __m512i v = _mm512_and_si512(_mm512_load_si512(a + k), _mm512_load_si512(b + k));
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
+    }
+    return static_cast<std::size_t>(_mm512_reduce_add_epi64(acc));
+#elif defined(__AVX2__)
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0f);
+    __m256i acc = _mm256_setzero_si256();
+    for (std::size_t k = 0; k < count; k += 4) {
+        __m256i v = _mm256_and_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(a + k)),
+                                     _mm256_load_si256(reinterpret_cast<const __m256i*>(b + k)));
+        __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, lowMask));
+        __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+    }
+    return static_cast<std::size_t>(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+                                     _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+#else
+    std::size_t total = 0;
+    for (std::size_t k = 0; k < count; ++k) {
+        total += std::popcount(a[k] & b[k]);
+    }
+    return total;
+#endif
+}
+
+// Транспонирование блока 64 x 64 общее со встраиваемым интерфейсом graph_view.hpp
+using graph_view::transposeTile;
+
+// Суммы столбцов битовой матрицы (входящие степени), накапливаемые по строкам
+// Вместо обхода столбцов с шагом в длину строки каждая строка прибавляется
+// к массиву байтовых счетчиков: байт строки раскладывается по таблице в
+// 64-битное слово из восьми байтов 0/1 и складывается с восемью счетчиками
+// одним сложением (SWAR). Строки читаются последовательно, а цикл сложения
+// векторизуется компилятором. Байтовые счетчики переносятся в int каждые
+// 255 строк, до переполнения
+class ColumnCounter {
+public:
+    explicit ColumnCounter(std::size_t words) : lanes(words * 8, 0), totals(words * 64, 0) {}
+
+    void add(const std::uint64_t* row) {
+        for (std::size_t w = 0; w < lanes.size() / 8; ++w) {
+            std::uint64_t bits = row[w];
+            if (bits == 0) continue;
+            std::uint64_t* lane = lanes.data() + w * 8;
+            for (int b = 0; b < 8; ++b) {
+                lane[b] += kSpread[(bits >> (8 * b)) & 0xff];
+            }
+        }
+        if (++pendingRows == 255) {
+            flush();
+        }
+    }
+
+    // Суммы столбцов (длина - число слов строки * 64)
+    const std::vector<int>& counts() {
+        flush();
+        return totals;
+    }
+
+private:
+    // Байт x -> слово, в котором байт t равен биту t числа x
+    static constexpr auto kSpread = [] {
+        std::array<std::uint64_t, 256> table{};
+        for (int x = 0; x < 256; ++x) {
+            for (int t = 0; t < 8; ++t) {
+                if ((x >> t) & 1) table[x] |= std::uint64_t{1} << (8 * t);
+            }
+        }
+        return table;
+    }();
+
+    void flush() {
+        for (std::size_t k = 0; k < lanes.size(); ++k) {
+            if (lanes[k] == 0) continue;
+            for (int t = 0; t < 8; ++t) {
+                totals[k * 8 + t] += static_cast<int>((lanes[k] >> (8 * t)) & 0xff);
+            }
+            lanes[k] = 0;
+        }
+        pendingRows = 0;
+    }
+
+    std::vector<std::uint64_t> lanes;  // Восемь байтовых счетчиков на слово
+    std::vector<int> totals;
+    int pendingRows = 0;
+};
+
+// Упакованная битовая матрица смежности
+// Каждое ребро занимает один бит вместо четырех байт int, все строки лежат
+// в одном непрерывном буфере, выровненном по 64 байта (размер строки кэша).
+// Длина строки дополняется нулями до кратной 8 словам, поэтому каждая строка
+// также начинается на границе строки кэша
+class BitMatrix {
+public:
+    static constexpr std::size_t kWordBits = 64;
+    static constexpr std::size_t kAlignment = 64;
+    static constexpr std::size_t kWordsPerLine = kAlignment / sizeof(std::uint64_t);
+
+    BitMatrix() = default;
+
+    // Создает нулевую матрицу n x n
+    explicit BitMatrix(int n) : BitMatrix(n, n) {}
+
+    // Создает нулевую матрицу rows x columns (например, буфер одной строки)
+    BitMatrix(int rows, int columns)
+        : size(rows), capacity(rows), stride(strideFor(columns)),
+          words(allocate(static_cast<std::size_t>(rows) * stride)) {}
+
+    // Длина строки в словах для матрицы с columns столбцами
+    static std::size_t strideFor(int columns) {
+        return (static_cast<std::size_t>(columns) + kWordBits * kWordsPerLine - 1) /
+               (kWordBits * kWordsPerLine) * kWordsPerLine;
+    }
+
+    // Увеличивает квадратную матрицу до n x n, новые строки и столбцы нулевые
+    // Место выделяется с запасом (вдвое), поэтому добавление вершин по одной
+    // стоит амортизированно O(n / 64) слов на вершину
+    void grow(int n) {
+        if (n <= size) return;
+        if (n > capacity || static_cast<std::size_t>(n) > stride * kWordBits) {
+            int newCapacity = std::max(n, 2 * capacity);
+            std::size_t newStride = strideFor(newCapacity);
+            auto newWords = allocate(static_cast<std::size_t>(newCapacity) * newStride);
+            for (int i = 0; i < size; ++i) {
+                std::copy_n(row(i), stride, newWords.get() + static_cast<std::size_t>(i) * newStride);
+            }
+            words = std::move(newWords);
+            stride = newStride;
+            capacity = newCapacity;
+        }
+        size = n;
+    }
+
+    bool empty() const { return size == 0; }
+    int dimension() const { return size; }
+    std::size_t wordsPerRow() const { return stride; }
+    std::size_t bytes() const { return static_cast<std::size_t>(size) * stride * sizeof(std::uint64_t); }
+
+    std::uint64_t* row(int i) { return words.get() + static_cast<std::size_t>(i) * stride; }
+    const std::uint64_t* row(int i) const { return words.get() + static_cast<std::size_t>(i) * stride; }
+
+    bool test(int i, int j) const {
+        return (row(i)[j / kWordBits] >> (j % kWordBits)) & 1u;
+    }
+
+    void set(int i, int j) {
+        row(i)[j / kWordBits] |= std::uint64_t{1} << (j % kWordBits);
+    }
+
+    void reset(int i, int j) {
+        row(i)[j / kWordBits] &= ~(std::uint64_t{1} << (j % kWordBits));
+    }
+
+    void clearRow(int i) {
+        std::fill_n(row(i), stride, std::uint64_t{0});
+    }
+
+    // Количество единиц в строке i (степень вершины)
+    int rowCount(int i) const {
+        return static_cast<int>(countBits(row(i), stride));
+    }
+
+    // Число блоков 64 x 64 по каждой стороне матрицы
+    int tileCount() const {
+        return static_cast<int>((static_cast<std::size_t>(size) + kWordBits - 1) / kWordBits);
+    }
+
+    // Копирует блок (tileRow, tileColumn) в tile: слово k - биты строки
+    // 64 * tileRow + k в столбцах 64 * tileColumn .. 64 * tileColumn + 63.
+    // Строки за пределами матрицы заполняются нулями
+    void loadTile(int tileRow, int tileColumn, std::uint64_t* tile) const {
+        int first = tileRow * static_cast<int>(kWordBits);
+        int rows = std::min(static_cast<int>(kWordBits), size - first);
+        for (int k = 0; k < rows; ++k) {
+            tile[k] = row(first + k)[tileColumn];
+        }
+        std::fill(tile + rows, tile + kWordBits, std::uint64_t{0});
+    }
+
+private:
+    struct AlignedDeleter {
+        void operator()(std::uint64_t* p) const {
+            ::operator delete[](p, std::align_val_t(kAlignment));
+        }
+    };
+
+    // Выделяет обнуленный выровненный буфер
+    static std::unique_ptr<std::uint64_t[], AlignedDeleter> allocate(std::size_t count) {
+        if (count == 0) return nullptr;
+        auto* p = static_cast<std::uint64_t*>(
+            ::operator new[](count * sizeof(std::uint64_t), std::align_val_t(kAlignment)));
+        std::fill_n(p, count, std::uint64_t{0});
+        return std::unique_ptr<std::uint64_t[], AlignedDeleter>(p);
+    }
+
+    int size = 0;
+    int capacity = 0;
+    std::size_t stride = 0;
+    std::unique_ptr<std::uint64_t[], AlignedDeleter> words;
+};
+
+// Сжатое разреженное представление графа (CSR)
+// Соседи всех вершин лежат подряд в одном массиве neighbors, а offsets[i]
+// указывает начало списка вершины i. Память O(n + m) вместо O(n^2),
+// степень вершины - разность соседних смещений
+class CsrAdjacency {
+public:
+    CsrAdjacency() = default;
+
+    // Строит CSR из списка ребер неориентированного графа с вершинами 0..n-1
+    // Каждое ребро попадает в списки обоих концов; списки соседей сортируются,
+    // что позволяет найти повторные ребра сравнением соседних элементов.
+    // Для ориентированного графа дуга u -> v попадает только в список u
+    CsrAdjacency(int n, const std::vector<std::pair<int, int>>& edges, bool directed = false)
+        : offsets(static_cast<std::size_t>(n) + 1, 0), neighbors(edges.size() * (directed ? 1 : 2)),
+          directed(directed) {
+        for (const auto& [u, v] : edges) {
+            ++offsets[u + 1];
+            if (!directed) ++offsets[v + 1];
+        }
+        for (int i = 0; i < n; ++i) {
+            offsets[i + 1] += offsets[i];
+        }
+        std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (const auto& [u, v] : edges) {
+            neighbors[cursor[u]++] = v;
+            if (!directed) neighbors[cursor[v]++] = u;
+        }
+        for (int i = 0; i < n; ++i) {
+            std::sort(neighbors.begin() + offsets[i], neighbors.begin() + offsets[i + 1]);
+        }
+    }
+
+    bool empty() const { return offsets.empty(); }
+    int dimension() const { return empty() ? 0 : static_cast<int>(offsets.size() - 1); }
+    std::size_t edgeCount() const { return directed ? neighbors.size() : neighbors.size() / 2; }
+
+    const int* begin(int i) const { return neighbors.data() + offsets[i]; }
+    const int* end(int i) const { return neighbors.data() + offsets[i + 1]; }
+
+    // Количество соседей вершины i (степень вершины)
+    int rowCount(int i) const {
+        return static_cast<int>(offsets[i + 1] - offsets[i]);
+    }
+
+    // Добавляет изолированную вершину в конец
+    void addVertex() {
+        if (offsets.empty()) offsets.push_back(0);
+        offsets.push_back(offsets.back());
+    }
+
+    // Есть ли ребро u - v с учетом еще не слитых изменений
+    bool contains(int u, int v) const {
+        std::uint64_t key = edgeKey(u, v);
+        if (removed.count(key)) return false;
+        if (added.count(key)) return true;
+        return std::binary_search(begin(u), end(u), v);
+    }
+
+    // Добавляет отсутствующее ребро. Изменения копятся в хеш-множествах
+    // поверх неизменного CSR (O(1) на операцию) и сливаются в массивы compact()
+    void insert(int u, int v) {
+        std::uint64_t key = edgeKey(u, v);
+        if (!removed.erase(key)) added.insert(key);
+    }
+
+    // Удаляет существующее ребро
+    void erase(int u, int v) {
+        std::uint64_t key = edgeKey(u, v);
+        if (!added.erase(key)) removed.insert(key);
+    }
+
+    bool hasPendingChanges() const { return !added.empty() || !removed.empty(); }
+
+    // Сливает накопленные изменения в массивы CSR за O(n + m + k log k),
+    // где k - число изменений. begin/end/rowCount отражают изменения только
+    // после слияния
+    void compact() {
+        if (!hasPendingChanges()) return;
+        int n = dimension();
+        std::vector<std::pair<int, int>> extra;
+        extra.reserve(added.size() * 2);
+        for (std::uint64_t key : added) {
+            int u = static_cast<int>(key >> 32), v = static_cast<int>(key & 0xffffffffu);
+            extra.emplace_back(u, v);
+            extra.emplace_back(v, u);
+        }
+        std::sort(extra.begin(), extra.end());
+        
+        std::vector<std::size_t> newOffsets(static_cast<std::size_t>(n) + 1, 0);
+        std::vector<int> newNeighbors;
+        newNeighbors.reserve(neighbors.size() + extra.size());
+        auto next = extra.begin();
+        for (int u = 0; u < n; ++u) {
+            const int* base = begin(u);
+            for (; base != end(u) || (next != extra.end() && next->first == u);) {
+                bool takeExtra = next != extra.end() && next->first == u &&
+                                 (base == end(u) || next->second < *base);
+                if (takeExtra) {
+                    newNeighbors.push_back((next++)->second);
+                } else {
+                    int v = *base++;
+                    if (removed.empty() || !removed.count(edgeKey(u, v))) {
+                        newNeighbors.push_back(v);
+                    }
+                }
+            }
+            newOffsets[u + 1] = newNeighbors.size();
+        }
+        offsets = std::move(newOffsets);
+        neighbors = std::move(newNeighbors);
+        added.clear();
+        removed.clear();
+    }
+
+    // Собирает CSR из готовых массивов (например, загруженных из .gbin)
+    CsrAdjacency(std::vector<std::size_t> rowOffsets, std::vector<int> adjacency, bool directed = false)
+        : offsets(std::move(rowOffsets)), neighbors(std::move(adjacency)), directed(directed) {}
+
+    const std::vector<std::size_t>& rowOffsets() const { return offsets; }
+    const std::vector<int>& adjacency() const { return neighbors; }
+
+    // Проверяет наличие повторных ребер (соседние равные элементы списков)
+    bool hasParallelEdges() const {
+        for (int i = 0; i < dimension(); ++i) {
+            if (std::adjacent_find(begin(i), end(i)) != end(i)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static std::uint64_t edgeKey(int u, int v) {
+        if (u > v) std::swap(u, v);
+        return (static_cast<std::uint64_t>(u) << 32) | static_cast<std::uint32_t>(v);
+    }
+
+    std::vector<std::size_t> offsets;
+    std::vector<int> neighbors;
+    bool directed = false;  // Списки исходящих дуг вместо списков соседей
+    std::unordered_set<std::uint64_t> added;  // Добавленные, но не слитые ребра
+    std::unordered_set<std::uint64_t> removed;  // Удаленные, но не слитые ребра
+};
+
+// Входной файл, отображенный в память только для чтения
+// Текст разбирается прямо из страниц файла, без копирования в буферы потока.
+// На системах без mmap файл целиком читается в память
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+#ifdef GRAPH_HAS_MMAP
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || ::fstat(fd, &info) != 0) {
+            if (fd >= 0) ::close(fd);
+            throw GraphError("Не удалось открыть входной файл: " + filename);
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        if (length > 0) {
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw GraphError("Не удалось открыть входной файл: " + filename);
+            }
+            ::madvise(mapped, length, MADV_SEQUENTIAL);
+            bytes = static_cast<const char*>(mapped);
+        }
+        ::close(fd);
+#else
+        std::ifstream fin(filename, std::ios::binary);
+        if (!fin) {
+            throw GraphError("Не удалось открыть входной файл: " + filename);
+        }
+        buffer.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef GRAPH_HAS_MMAP
+        if (bytes) ::munmap(const_cast<char*>(bytes), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return bytes; }
+    const char* end() const { return bytes + length; }
+    std::size_t size() const { return length; }
+
+    // Сообщает системе, что страницы до upTo больше не нужны, чтобы
+    // потоковое чтение не удерживало в памяти уже разобранную часть файла
+    void release(const char* upTo) {
+#ifdef GRAPH_HAS_MMAP
+        static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        std::size_t prefix = static_cast<std::size_t>(upTo - bytes) / page * page;
+        if (prefix > 0) {
+            ::madvise(const_cast<char*>(bytes), prefix, MADV_DONTNEED);
+        }
+#else
+        (void)upTo;
+#endif
+    }
+
+private:
+    const char* bytes = nullptr;
+    std::size_t length = 0;
+#ifndef GRAPH_HAS_MMAP
+    std::vector<char> buffer;
+#endif
+};
+
+// Разбор текста входного файла без локали и sentry потоков ввода
+// Числа читаются через std::from_chars, а строки матрицы смежности
+// классифицируются блоками по 32 байта (SSE2/AVX2): за одно сравнение
+// определяется, какие байты являются '0', '1' или пробельными символами
+class TextScanner {
+public:
+    TextScanner(const char* begin, const char* end) : pos(begin), last(end) {}
+
+    // Пропускает пробельные символы, включая переводы строк
+    void skipSpaces() {
+        while (pos < last && isSpace(*pos)) ++pos;
+    }
+
+    bool atEnd() const { return pos == last; }
+    const char* position() const { return pos; }
+    std::size_t remaining() const { return static_cast<std::size_t>(last - pos); }
+
+    // Читает следующий непробельный символ
+    bool readSymbol(char& symbol) {
+        skipSpaces();
+        if (pos == last) return false;
+        symbol = *pos++;
+        return true;
+    }
+
+    // Есть ли еще токены в текущей строке
+    bool hasTokenOnLine() {
+        while (pos < last && *pos != '\n' && isSpace(*pos)) ++pos;
+        return pos < last && *pos != '\n';
+    }
+
+    // Читает следующее целое число, как operator>> (допускается знак)
+    // Возвращает false, если данные закончились или токен не является числом
+    template <typename T>
+    bool readInt(T& value) {
+        skipSpaces();
+        const char* start = pos;
+        if (start < last && *start == '+' && start + 1 < last && isDigit(start[1])) ++start;
+        auto [next, ec] = std::from_chars(start, last, value);
+        if (ec != std::errc{}) return false;
+        pos = next;
+        return true;
+    }
+
+    // Читает строку rowIndex матрицы смежности из n значений 0/1 прямо
+    // в упакованную строку row. Сообщения об ошибках совпадают с
+    // поэлементным чтением: указываются строка и столбец плохого токена
+    void readBitRow(std::uint64_t* row, int n, int rowIndex) {
+        int j = 0;
+        while (j < n) {
+            j += scanBlocks(row, j, n);
+            if (j == n) break;
+            // Нестандартный блок (другие числа, многозначные токены,
+            // конец файла): один токен разбирается обычным способом
+            int value;
+            if (!readInt(value)) {
+                throw GraphError("Ошибка при чтении элемента матрицы [" + 
+                                std::to_string(rowIndex) + "][" + std::to_string(j) + "]");
+            }
+            if (value != 0 && value != 1) {
+                throw GraphError("Матрица смежности должна содержать только 0 и 1");
+            }
+            if (value == 1) {
+                row[j / 64] |= std::uint64_t{1} << (j % 64);
+            }
+            ++j;
+        }
+    }
+
+private:
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    // Маски байтов блока из 32 символов: цифры 0/1, единицы, пробелы
+    struct BlockMasks {
+        std::uint32_t digits;
+        std::uint32_t ones;
+        std::uint32_t spaces;
+    };
+
+    static BlockMasks classify(const char* p) {
+#if defined(__AVX2__)
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i zero = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('0'));
+        __m256i one = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('1'));
+        __m256i space = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))));
+        return {static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(zero, one))),
+                static_cast<std::uint32_t>(_mm256_movemask_epi8(one)),
+                static_cast<std::uint32_t>(_mm256_movemask_epi8(space))};
+#elif defined(__SSE2__)
+        BlockMasks masks{0, 0, 0};
+        for (int half = 0; half < 2; ++half) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + half * 16));
+            __m128i zero = _mm_cmpeq_epi8(v, _mm_set1_epi8('0'));
+            __m128i one = _mm_cmpeq_epi8(v, _mm_set1_epi8('1'));
+            __m128i space = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                             _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                             _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+            int shift = half * 16;
+            masks.digits |= static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(zero, one))) << shift;
+            masks.ones |= static_cast<std::uint32_t>(_mm_movemask_epi8(one)) << shift;
+            masks.spaces |= static_cast<std::uint32_t>(_mm_movemask_epi8(space)) << shift;
+        }
+        return masks;
+#else
+        BlockMasks masks{0, 0, 0};
+        for (int k = 0; k < 32; ++k) {
+            char c = p[k];
+            std::uint32_t bit = std::uint32_t{1} << k;
+            if (c == '0' || c == '1') masks.digits |= bit;
+            if (c == '1') masks.ones |= bit;
+            if (c == ' ' || c == '\n' || c == '\r' || c == '\t') masks.spaces |= bit;
+        }
+        return masks;
+#endif
+    }
+
+    // Оставляет в маске только count младших установленных битов
+    static std::uint32_t lowestBits(std::uint32_t mask, int count) {
+#if defined(__BMI2__)
+        return _pdep_u32((std::uint32_t{1} << count) - 1, mask);
+#else
+        std::uint32_t kept = 0;
+        for (int k = 0; k < count; ++k) {
+            kept |= mask & (0u - mask);
+            mask &= mask - 1;
+        }
+        return kept;
+#endif
+    }
+
+    // Собирает значения токенов (биты ones в позициях starts) подряд
+    static std::uint32_t gatherValues(std::uint32_t ones, std::uint32_t starts) {
+#if defined(__BMI2__)
+        return _pext_u32(ones, starts);
+#else
+        std::uint32_t values = 0;
+        for (int k = 0; starts; ++k, starts &= starts - 1) {
+            if (ones & starts & (0u - starts)) values |= std::uint32_t{1} << k;
+        }
+        return values;
+#endif
+    }
+
+    // Векторный разбор строки матрицы, начиная со столбца j
+    // Блок принимается, только если он состоит из одиночных символов 0/1,
+    // разделенных пробелами (проверяется и первый байт следующего блока,
+    // чтобы не разрезать многозначное число). Возвращает число прочитанных
+    // значений; разбор останавливается на первом нестандартном блоке
+    int scanBlocks(std::uint64_t* row, int j, int n) {
+        int start = j;
+        while (j < n && last - pos > 32) {
+            BlockMasks masks = classify(pos);
+            if ((masks.digits | masks.spaces) != 0xffffffffu) break;
+            std::uint32_t followed = (masks.digits >> 1) |
+                                     (static_cast<std::uint32_t>(isDigit(pos[32])) << 31);
+            if (masks.digits & followed) break;
+
+            std::uint32_t starts = masks.digits;
+            int count = std::popcount(starts);
+            int advance = 32;
+            if (count > n - j) {
+                count = n - j;
+                starts = lowestBits(starts, count);
+                advance = 32 - std::countl_zero(starts);
+            }
+            if (count > 0) {
+                std::uint64_t values = gatherValues(masks.ones & starts, starts);
+                int offset = j % 64;
+                row[j / 64] |= values << offset;
+                if (offset + count > 64) {
+                    row[j / 64 + 1] |= values >> (64 - offset);
+                }
+            }
+            j += count;
+            pos += advance;
+        }
+        return j - start;
+    }
+
+    const char* pos;
+    const char* last;
+};
+
+// Степени вершин с гистограммой "степень -> число вершин"
+// Изменение степени одной вершины на единицу обновляет гистограмму и
+// наименьшую/наибольшую степени за O(1): если последняя вершина покинула
+// крайнюю степень, новая граница отстоит от старой ровно на единицу.
+// Поэтому запросы min/max, изолированных вершин и регулярности - O(1)
+// Гистограмма - плотный массив, пока степени меньше max(n, kDenseDegrees);
+// у простого графа так всегда. Степени мультиграфа доходят до INT_MAX, и
+// тогда гистограмма переходит в разреженную форму (std::map по встречающимся
+// степеням): память и проходы по ней зависят от числа различных степеней,
+// а не от наибольшей степени
+class DegreeIndex {
+public:
+    // Наибольшая степень, для которой плотный массив допустим при любом n (4 МБ)
+    static constexpr std::size_t kDenseDegrees = std::size_t{1} << 20;
+
+    // Строит индекс по вектору степеней за один проход
+    void assign(std::vector<int> values) {
+        degrees = std::move(values);
+        histogram.clear();
+        sparse.clear();
+        dense = true;
+        minValue = degrees.empty() ? 0 : INT_MAX;
+        maxValue = 0;
+        for (int d : degrees) {
+            count(d);
+        }
+    }
+
+    // Добавляет вершину с известной степенью (потоковое накопление)
+    void append(int degree) {
+        degrees.push_back(degree);
+        if (degrees.size() == 1) minValue = INT_MAX;
+        count(degree);
+    }
+
+    void increment(int v) {
+        int d = degrees[v]++;
+        add(d, -1);
+        add(d + 1, 1);
+        if (d + 1 > maxValue) maxValue = d + 1;
+        if (d == minValue && verticesWithDegree(d) == 0) minValue = d + 1;
+    }
+
+    void decrement(int v) {
+        int d = degrees[v]--;
+        add(d, -1);
+        add(d - 1, 1);
+        if (d - 1 < minValue) minValue = d - 1;
+        if (d == maxValue && verticesWithDegree(d) == 0) maxValue = d - 1;
+    }
+
+    const std::vector<int>& values() const { return degrees; }
+    
+    // Переставляет степени: степень вершины k переходит на место position[k]
+    // Гистограмма и диапазон от перестановки не меняются и не пересчитываются
+    void scatter(const std::vector<int>& position) {
+        std::vector<int> result(degrees.size());
+        for (std::size_t k = 0; k < degrees.size(); ++k) {
+            result[position[k]] = degrees[k];
+        }
+        degrees = std::move(result);
+    }
+    
+    int minDegree() const { return minValue; }
+    int maxDegree() const { return maxValue; }
+
+    // Число вершин степени d
+    int verticesWithDegree(int d) const {
+        if (!dense) {
+            auto it = sparse.find(d);
+            return it != sparse.end() ? it->second : 0;
+        }
+        return d >= 0 && static_cast<std::size_t>(d) < histogram.size() ? histogram[d] : 0;
+    }
+
+    // Вызывает f(d, count) для каждой встречающейся степени d по возрастанию
+    template <typename F>
+    void forEachDegree(F&& f) const {
+        if (!dense) {
+            for (const auto& [d, c] : sparse) f(d, c);
+            return;
+        }
+        if (degrees.empty()) return;
+        for (int d = minValue; d <= maxValue; ++d) {
+            if (int c = histogram[d]) f(d, c);
+        }
+    }
+
+    bool hasIsolated() const { return verticesWithDegree(0) > 0; }
+    bool isRegular() const { return !degrees.empty() && minValue == maxValue; }
+
+    // Процентили сводки распределения (nearest-rank)
+    static constexpr std::array<int, 5> kPercentiles = {25, 75, 90, 95, 99};
+
+    // Сводка распределения степеней
+    struct Summary {
+        double mean = 0;
+        double variance = 0;  // Дисперсия по всем вершинам
+        double median = 0;    // Для четного n - среднее двух средних значений
+        std::array<int, kPercentiles.size()> percentiles{};
+    };
+
+    // Считает среднее, дисперсию, медиану и процентили одним проходом по
+    // гистограмме без копирования и сортировки вектора степеней:
+    // гистограмма и есть сортировка подсчетом, поэтому k-е по величине значение -
+    // первая степень, на которой накопленное число вершин достигает k.
+    // Среднее и дисперсия накапливаются по корзинам формулой Уэлфорда
+    Summary summarize() const {
+        Summary summary;
+        long long n = static_cast<long long>(degrees.size());
+        if (n == 0) return summary;
+        // Ранги (с 1) искомых порядковых статистик в порядке возрастания:
+        // процентиль 25, нижняя и верхняя середины для медианы (при нечетном
+        // n совпадают), остальные процентили
+        std::array<long long, kPercentiles.size() + 2> ranks{};
+        auto rankOf = [&](int p) { return std::max(1LL, (p * n + 99) / 100); };
+        ranks[0] = rankOf(kPercentiles[0]);
+        ranks[1] = (n + 1) / 2;
+        ranks[2] = n / 2 + 1;
+        for (std::size_t k = 1; k < kPercentiles.size(); ++k) {
+            ranks[k + 2] = rankOf(kPercentiles[k]);
+        }
+        std::array<int, ranks.size()> values{};
+        std::size_t next = 0;
+        long long seen = 0;
+        double m2 = 0;
+        forEachDegree([&](int d, long long c) {
+            seen += c;
+            double delta = d - summary.mean;
+            summary.mean += delta * static_cast<double>(c) / static_cast<double>(seen);
+            m2 += static_cast<double>(c) * delta * (d - summary.mean);
+            while (next < ranks.size() && ranks[next] <= seen) {
+                values[next++] = d;
+            }
+        });
+        summary.variance = m2 / static_cast<double>(n);
+        summary.median = (values[1] + values[2]) / 2.0;
+        summary.percentiles[0] = values[0];
+        for (std::size_t k = 1; k < kPercentiles.size(); ++k) {
+            summary.percentiles[k] = values[k + 2];
+        }
+        return summary;
+    }
+
+private:
+    void count(int d) {
+        add(d, 1);
+        minValue = std::min(minValue, d);
+        maxValue = std::max(maxValue, d);
+    }
+
+    // Меняет число вершин степени d на delta; степень за пределом плотного
+    // массива переводит гистограмму в разреженную форму
+    void add(int d, int delta) {
+        std::size_t slot = static_cast<std::size_t>(d);
+        if (dense && slot >= histogram.size()) {
+            if (slot < std::max(kDenseDegrees, degrees.size())) {
+                histogram.resize(slot + 1, 0);
+            } else {
+                for (std::size_t k = 0; k < histogram.size(); ++k) {
+                    if (histogram[k]) sparse.emplace(static_cast<int>(k), histogram[k]);
+                }
+                std::vector<int>().swap(histogram);
+                dense = false;
+            }
+        }
+        if (dense) {
+            histogram[slot] += delta;
+        } else if ((sparse[d] += delta) == 0) {
+            sparse.erase(d);
+        }
+    }
+
+    std::vector<int> degrees;
+    std::vector<int> histogram;     // Плотная форма: histogram[d] - число вершин степени d
+    std::map<int, int> sparse;      // Разреженная форма: только встречающиеся степени
+    bool dense = true;
+    int minValue = 0;
+    int maxValue = 0;
+};
+
+// Буферизованная запись отчета в файл
+// Числа форматируются std::to_chars прямо в буфер на 1 МБ, без локали и без
+// выделений памяти на строку; буфер сбрасывается в файл большими блоками.
+// Вещественные числа выводятся с фиксированной точкой и 6 знаками после
+// запятой, как std::fixed << std::setprecision(6)
+class ReportWriter {
+public:
+    static constexpr std::size_t kBufferSize = 1 << 20;
+
+    explicit ReportWriter(const std::string& filename, bool binary = false)
+        : filename(filename),
+          fout(filename, binary ? std::ios::out | std::ios::binary : std::ios::out),
+          buffer(new char[kBufferSize]) {
+        if (!fout) {
+            throw GraphError("Не удалось открыть выходной файл: " + filename);
+        }
+    }
+
+    ReportWriter& operator<<(std::string_view text) {
+        write(text.data(), text.size());
+        return *this;
+    }
+
+    ReportWriter& operator<<(char symbol) {
+        reserve(1);
+        buffer[used++] = symbol;
+        return *this;
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    ReportWriter& operator<<(T value) {
+        reserve(24);
+        used = static_cast<std::size_t>(std::to_chars(buffer.get() + used, buffer.get() + kBufferSize, value).ptr -
+                                        buffer.get());
+        return *this;
+    }
+
+    ReportWriter& operator<<(double value) {
+        reserve(64);
+        auto result = std::to_chars(buffer.get() + used, buffer.get() + kBufferSize, value,
+                                    std::chars_format::fixed, 6);
+        if (result.ec != std::errc()) {
+            // Очень большие значения не помещаются в резерв - пишутся через строку
+            return *this << std::string_view(std::to_string(value));
+        }
+        used = static_cast<std::size_t>(result.ptr - buffer.get());
+        return *this;
+    }
+
+    // Записывает байты как есть (для двоичных форматов)
+    void write(const void* data, std::size_t bytes) {
+        const char* source = static_cast<const char*>(data);
+        if (bytes > kBufferSize - used) {
+            flush();
+            if (bytes >= kBufferSize) {
+                fout.write(source, static_cast<std::streamsize>(bytes));
+                return;
+            }
+        }
+        std::memcpy(buffer.get() + used, source, bytes);
+        used += bytes;
+    }
+
+    // Сбрасывает буфер и закрывает файл; ошибки записи - исключение
+    void close() {
+        flush();
+        fout.close();
+        if (!fout) {
+            throw GraphError("Ошибка записи в файл: " + filename);
+        }
+    }
+
+private:
+    void reserve(std::size_t bytes) {
+        if (kBufferSize - used < bytes) {
+            flush();
+        }
+    }
+
+    void flush() {
+        fout.write(buffer.get(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+
+    std::string filename;
+    std::ofstream fout;
+    std::unique_ptr<char[]> buffer;
+    std::size_t used = 0;
+};
+
+// Формат файла результатов: текстовый отчет FN2.txt, CSV "vertex,degree"
+// или двоичный массив степеней (см. DegreeFileHeader)
+enum class ReportFormat { Text, Csv, Binary };
+
+// Порядок вершин во внутреннем хранении: исходный, по убыванию степени
+// или обратный алгоритм Катхилла - Макки (RCM)
+enum class VertexOrder { Original, DegreeDescending, ReverseCuthillMcKee };
+
+// Заголовок двоичного файла степеней: за ним следуют vertices чисел int32
+// (little-endian), степени вершин по порядку. Для ориентированного графа
+// (флаг kDirected) это исходящие степени, за ними - vertices входящих.
+// Версия 2 добавила поле flags
+struct DegreeFileHeader {
+    static constexpr char kMagic[4] = {'G', 'D', 'E', 'G'};
+    static constexpr std::uint32_t kVersion = 2;
+    static constexpr std::uint32_t kDirected = 1;  // Флаг: есть входящие степени
+
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t vertices;
+    std::int32_t minDegree;
+    std::int32_t maxDegree;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(DegreeFileHeader) == 32, "Заголовок файла степеней должен занимать 32 байта");
+
+// 64-битная контрольная сумма для двоичного формата .gbin
+// Данные обрабатываются словами по четыре независимые цепочки
+// умножения-сдвига, поэтому скорость близка к скорости чтения памяти
+inline std::uint64_t checksum64(const void* data, std::size_t size) {
+    constexpr std::uint64_t kPrime = 0x9e3779b97f4a7c15ULL;
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    std::uint64_t lanes[4] = {kPrime, kPrime ^ 1, kPrime ^ 2, kPrime ^ 3};
+    std::size_t k = 0;
+    for (; k + 32 <= size; k += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            std::uint64_t word;
+            std::memcpy(&word, bytes + k + lane * 8, 8);
+            lanes[lane] = (lanes[lane] ^ word) * kPrime;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+    std::uint64_t hash = size;
+    for (int lane = 0; lane < 4; ++lane) {
+        hash = (hash ^ lanes[lane]) * kPrime;
+        hash ^= hash >> 32;
+    }
+    for (; k < size; ++k) {
+        hash = (hash ^ bytes[k]) * kPrime;
+    }
+    return hash;
+}
+
+// Заголовок двоичного файла графа .gbin (64 байта)
+// За заголовком идут секции, каждая выровнена по 64 байта:
+// - плотный граф: строки BitMatrix по wordsPerRow слов;
+// - CSR: n + 1 смещений (uint64) и 2m номеров соседей (int32);
+// - необязательно: n степеней (int32), их диапазон хранится в заголовке.
+// checksum покрывает заголовок (см. fileChecksum) и все байты после него.
+// Числа хранятся в порядке байтов little-endian
+struct GraphFileHeader {
+    static constexpr char kMagic[4] = {'G', 'B', 'I', 'N'};
+    static constexpr std::uint32_t kVersion = 2;  // 2: контрольная сумма покрывает заголовок
+    static constexpr std::uint32_t kSparse = 1;  // Флаг: CSR вместо матрицы
+    static constexpr std::uint32_t kDegrees = 2;  // Флаг: есть секция степеней
+    static constexpr std::uint32_t kDirected = 4;  // Флаг: ориентированный граф
+
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::int32_t minDegree;
+    std::uint64_t vertices;
+    std::uint64_t edgeCount;
+    std::uint64_t wordsPerRow;
+    std::uint64_t payloadBytes;
+    std::uint64_t checksum;
+    std::int32_t maxDegree;
+    std::uint32_t reserved;
+    
+    // Контрольная сумма файла: сумма заголовка, в котором поле checksum
+    // заменено суммой данных. Поля, по которым выделяется память
+    // (vertices, edgeCount, flags, wordsPerRow), тоже защищены
+    static std::uint64_t fileChecksum(GraphFileHeader header, const char* payload) {
+        header.checksum = checksum64(payload, header.payloadBytes);
+        return checksum64(&header, sizeof(header));
+    }
+};
+static_assert(sizeof(GraphFileHeader) == 64, "Заголовок .gbin должен занимать 64 байта");
+
+// Время этапов загрузки и обработки графа в секундах (параметр --timings)
+// Для матрицы степени считаются в одном проходе с проверкой и входят в validate
+struct PhaseTimings {
+    double parse = 0;  // Отображение файла и разбор текста
+    double validate = 0;  // Проверка корректности
+    double degrees = 0;  // Подсчет степеней
+    double reorder = 0;  // Перенумерация вершин
+    double analysis = 0;  // Компоненты связности и треугольники
+    double report = 0;  // Запись файла результатов
+};
+
+// Пул потоков для параллельной обработки строк графа
+// Вызывающий поток участвует в работе наравне с фоновыми, поэтому пул
+// с параллельностью N создает N - 1 фоновых потоков
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned concurrency = std::thread::hardware_concurrency()) {
+        for (unsigned k = 1; k < concurrency; ++k) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Число потоков, одновременно выполняющих работу (с учетом вызывающего)
+    unsigned concurrency() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Выполняет body(begin, end) для блоков диапазона [0, count) размером
+    // blockSize и ждет завершения. Блоки раздаются динамически через атомарный
+    // счетчик, что выравнивает нагрузку при разной стоимости строк.
+    // Первое исключение из body пробрасывается вызывающему
+    void parallelFor(std::size_t count, std::size_t blockSize,
+                     const std::function<void(std::size_t, std::size_t)>& body) {
+        std::size_t blocks = (count + blockSize - 1) / blockSize;
+        if (blocks <= 1 || workers.empty()) {
+            if (count > 0) body(0, count);
+            return;
+        }
+
+        // Общее состояние живет, пока его держит хотя бы одна задача: помощник,
+        // запущенный после завершения цикла, просто выходит, не трогая body
+        struct Job {
+            std::atomic<std::size_t> next{0};
+            std::mutex mutex;
+            std::condition_variable done;
+            unsigned active = 0;
+            bool finished = false;
+            std::exception_ptr error;
+        };
+        auto job = std::make_shared<Job>();
+        auto run = [job, blocks, count, blockSize, &body] {
+            for (std::size_t b; (b = job->next.fetch_add(1)) < blocks;) {
+                try {
+                    body(b * blockSize, std::min(count, (b + 1) * blockSize));
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(job->mutex);
+                    if (!job->error) job->error = std::current_exception();
+                }
+            }
+        };
+
+        std::size_t helpers = std::min<std::size_t>(workers.size(), blocks - 1);
+        for (std::size_t k = 0; k < helpers; ++k) {
+            submit([job, run] {
+                {
+                    std::lock_guard<std::mutex> lock(job->mutex);
+                    if (job->finished) return;
+                    ++job->active;
+                }
+                run();
+                std::lock_guard<std::mutex> lock(job->mutex);
+                if (--job->active == 0) job->done.notify_all();
+            });
+        }
+        run();
+
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->done.wait(lock, [&] { return job->active == 0; });
+        job->finished = true;
+        if (job->error) std::rethrow_exception(job->error);
+    }
+
+    // Ставит задачу в очередь фоновых потоков
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        wakeup.notify_one();
+    }
+
+private:
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeup.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+};
+
+// Типизированные ядра графа: typed::Graph<Direction, Storage, Weight, Edges>
+// Политики выбираются при компиляции, поэтому циклы чтения, проверки и
+// подсчета степеней специализируются через if constexpr и не содержат
+// ветвлений по режиму. Мультиграф целиком читается ядром typed::Graph, а
+// класс Graph передает политики Direction и DenseStorage/SparseStorage своим
+// циклам (изменения ребер, степени, ядра, потоковое чтение) через withPolicies:
+// режим выбирается один раз при входе в цикл
+namespace typed {
+
+// Направленность: неориентированный граф требует симметричной матрицы
+struct Undirected {
+    static constexpr bool kDirected = false;
+};
+struct Directed {
+    static constexpr bool kDirected = true;
+};
+
+// Простой граф: ячейка матрицы 0 или 1, петли и повторные ребра запрещены
+struct SimpleEdges {
+    static constexpr bool kMultiple = false;
+    static constexpr bool kLoops = false;
+};
+
+// Мультиграф: ячейка - число ребер между вершинами, петли разрешены.
+// В неориентированном графе петля добавляет к степени вершины 2
+// (так петли пытается учитывать решение GPT-4o)
+struct MultiEdges {
+    static constexpr bool kMultiple = true;
+    static constexpr bool kLoops = true;
+};
+
+// Способы хранения
+struct DenseStorage {};  // n x n: массив ячеек
+struct SparseStorage {};  // Отсортированные списки соседей с весами
+
+template <typename Storage, typename Weight>
+class Cells;
+
+// Прибавляет вес к ячейке; переполнение типа ячейки - ошибка, а не
+// молчаливое усечение кратности
+template <typename Weight>
+void accumulate(Weight& cell, Weight w) {
+    if (__builtin_add_overflow(cell, w, &cell)) {
+        throw GraphError("Кратность ребра превышает допустимое значение");
+    }
+}
+
+// Плотное хранение с числовыми ячейками (кратности или веса ребер)
+template <typename Weight>
+class Cells<DenseStorage, Weight> {
+public:
+    explicit Cells(int n) : size(n), cells(static_cast<std::size_t>(n) * n, Weight{}) {}
+
+    Weight get(int i, int j) const { return cells[index(i, j)]; }
+    void add(int i, int j, Weight w) { accumulate(cells[index(i, j)], w); }
+    long long rowSum(int i) const {
+        const Weight* row = cells.data() + index(i, 0);
+        return std::accumulate(row, row + size, 0LL);
+    }
+
+    std::vector<long long> columnSums(int n) const {
+        // Строки прибавляются к вектору сумм целиком - доступ последовательный
+        std::vector<long long> sums(n, 0);
+        for (int i = 0; i < n; ++i) {
+            const Weight* row = cells.data() + index(i, 0);
+            for (int j = 0; j < n; ++j) {
+                sums[j] += row[j];
+            }
+        }
+        return sums;
+    }
+
+private:
+    std::size_t index(int i, int j) const { return static_cast<std::size_t>(i) * size + j; }
+
+    int size;
+    std::vector<Weight> cells;
+};
+
+// Разреженное хранение: для каждой вершины отсортированный список (сосед, вес)
+template <typename Weight>
+class Cells<SparseStorage, Weight> {
+public:
+    explicit Cells(int n) : lists(n) {}
+
+    Weight get(int i, int j) const {
+        auto it = find(lists[i], j);
+        return it != lists[i].end() && it->first == j ? it->second : Weight{};
+    }
+    void add(int i, int j, Weight w) {
+        auto& list = lists[i];
+        auto it = find(list, j);
+        if (it != list.end() && it->first == j) {
+            accumulate(it->second, w);
+        } else {
+            list.insert(it, {j, w});
+        }
+    }
+    long long rowSum(int i) const {
+        long long sum = 0;
+        for (const auto& entry : lists[i]) sum += entry.second;
+        return sum;
+    }
+
+    std::vector<long long> columnSums(int n) const {
+        std::vector<long long> sums(n, 0);
+        for (const auto& list : lists) {
+            for (const auto& [j, w] : list) sums[j] += w;
+        }
+        return sums;
+    }
+
+private:
+    using List = std::vector<std::pair<int, Weight>>;
+
+    static auto find(const List& list, int j) {
+        return std::lower_bound(list.begin(), list.end(), j,
+                                [](const std::pair<int, Weight>& entry, int key) { return entry.first < key; });
+    }
+    static auto find(List& list, int j) {
+        return std::lower_bound(list.begin(), list.end(), j,
+                                [](const std::pair<int, Weight>& entry, int key) { return entry.first < key; });
+    }
+
+    std::vector<List> lists;
+};
+
+template <typename Direction, typename Storage, typename Weight = int, typename Edges = SimpleEdges>
+class Graph {
+    static_assert(std::is_integral_v<Weight> && !std::is_same_v<Weight, bool>,
+                  "Ячейка графа - целое число (кратность или вес ребра)");
+
+public:
+    explicit Graph(int n) : vertices(n), cells(n) {}
+
+    int vertexCount() const { return vertices; }
+    Weight edge(int u, int v) const { return cells.get(u, v); }
+
+    // Читает матрицу смежности vertices x vertices поэлементно с проверкой
+    // значения по политике ребер. Кратность вне диапазона Weight - ошибка
+    void readMatrix(TextScanner& scanner) {
+        for (int i = 0; i < vertices; ++i) {
+            for (int j = 0; j < vertices; ++j) {
+                long long value;
+                if (!scanner.readInt(value)) {
+                    throw GraphError("Ошибка при чтении элемента матрицы [" + 
+                                    std::to_string(i) + "][" + std::to_string(j) + "]");
+                }
+                if constexpr (Edges::kMultiple) {
+                    if (value < 0) {
+                        throw GraphError("Кратность ребра не может быть отрицательной");
+                    }
+                    if (value > std::numeric_limits<Weight>::max()) {
+                        throw GraphError("Кратность ребра превышает допустимое значение: элемент [" +
+                                        std::to_string(i) + "][" + std::to_string(j) + "]");
+                    }
+                } else if (value != 0 && value != 1) {
+                    throw GraphError("Матрица смежности должна содержать только 0 и 1");
+                }
+                if (value != 0) {
+                    cells.add(i, j, static_cast<Weight>(value));
+                }
+            }
+        }
+    }
+
+    // Добавляет ребро (дугу) u -> v; в неориентированном графе ячейки
+    // симметричны. Простой граф отклоняет петли и повторные ребра
+    void addEdge(int u, int v, Weight w = Weight{1}) {
+        if constexpr (!Edges::kLoops) {
+            if (u == v) {
+                throw GraphError("На главной диагонали должны быть нули");
+            }
+        }
+        if constexpr (!Edges::kMultiple) {
+            if (cells.get(u, v) != Weight{}) {
+                throw GraphError("Список ребер содержит повторные ребра");
+            }
+        }
+        cells.add(u, v, w);
+        if constexpr (!Direction::kDirected) {
+            if (u != v) cells.add(v, u, w);
+        }
+    }
+
+    // Проверяет матрицу построчно: сначала диагональ, затем (для
+    // неориентированного графа) совпадение строки со столбцом - в том же
+    // порядке, что и проверка в классе Graph
+    void validate() const {
+        for (int i = 0; i < vertices; ++i) {
+            if constexpr (!Edges::kLoops) {
+                if (cells.get(i, i) != Weight{}) {
+                    throw GraphError("На главной диагонали должны быть нули");
+                }
+            }
+            if constexpr (!Direction::kDirected) {
+                for (int j = 0; j < vertices; ++j) {
+                    if (cells.get(i, j) != cells.get(j, i)) {
+                        throw GraphError("Матрица смежности должна быть симметричной");
+                    }
+                }
+            }
+        }
+    }
+
+    // Степени вершин (исходящие для орграфа): сумма строки; петля
+    // неориентированного мультиграфа учитывается дважды. Суммы
+    // накапливаются в 64 битах, степень больше INT_MAX - ошибка
+    std::vector<int> degrees() const {
+        std::vector<int> result(vertices);
+        for (int i = 0; i < vertices; ++i) {
+            long long degree = cells.rowSum(i);
+            if constexpr (Edges::kLoops && !Direction::kDirected) {
+                degree += cells.get(i, i);
+            }
+            result[i] = narrowDegree(degree, i);
+        }
+        return result;
+    }
+
+    // Входящие степени (суммы столбцов) ориентированного графа
+    std::vector<int> inDegrees() const requires Direction::kDirected {
+        std::vector<long long> sums = cells.columnSums(vertices);
+        std::vector<int> result(vertices);
+        for (int j = 0; j < vertices; ++j) {
+            result[j] = narrowDegree(sums[j], j);
+        }
+        return result;
+    }
+
+private:
+    static int narrowDegree(long long degree, int v) {
+        if (degree > INT_MAX) {
+            throw GraphError("Степень вершины " + std::to_string(v + 1) + " превышает " + std::to_string(INT_MAX));
+        }
+        return static_cast<int>(degree);
+    }
+
+    int vertices;
+    Cells<Storage, Weight> cells;
+};
+
+} // namespace typed
+
+// Основной класс для работы с графом
+// Объединяет функциональность из решений DeepSeek, Mistral и GPT-4o
+class Graph {
+private:
+    // Способ хранения: плотная битовая матрица для небольших графов,
+    // заданных матрицей, CSR для графов, заданных списком ребер, и потоковый
+    // режим, в котором матрица не хранится - остаются только степени
+    enum class Storage { Dense, Sparse, Streamed };
+    
+    // Число компонент связности и размер наибольшей из них
+    struct ComponentSummary {
+        int count = 0;
+        int largest = 0;
+    };
+    
+    // Ядерное разложение: ядерное число вершины - наибольшее k, при котором
+    // она входит в k-ядро (подграф, где у всех вершин степень не меньше k)
+    struct CoreDecomposition {
+        std::vector<int> core;
+        std::vector<int> order;  // Порядок вырожденности (порядок удаления вершин)
+        int degeneracy = 0;      // Наибольшее ядерное число
+    };
+    
+    // Максимальное число вершин для чтения матрицы смежности
+    // (64K вершин - это 512 МБ упакованной матрицы)
+    static constexpr int kMaxDenseVertices = 1 << 16;
+    
+    // Максимальное число вершин матрицы мультиграфа (ячейка int - 4 байта,
+    // 16K вершин - это 1 ГБ)
+    static constexpr int kMaxMultigraphVertices = 1 << 14;
+    
+    // Строк в блоке параллельной обработки и минимальное число вершин,
+    // начиная с которого работа распределяется по пулу потоков
+    static constexpr int kRowBlock = 64;
+    static constexpr int kParallelThreshold = 1024;
+    
+    Storage storage;  // Текущий способ хранения
+    BitMatrix adjacencyMatrix;  // Упакованная матрица смежности графа
+    mutable CsrAdjacency adjacencyLists;  // Списки смежности в формате CSR
+    DegreeIndex degreeIndex;  // Степени вершин (исходящие для орграфа) и их гистограмма
+    DegreeIndex inDegreeIndex;  // Входящие степени ориентированного графа
+    bool directed = false;  // Ориентированный граф: матрица не обязана быть симметричной
+    bool multigraph = false;  // Ячейки матрицы - кратности ребер, петли разрешены
+    std::vector<int> originalIndex;  // Внутренний номер вершины -> исходный (пусто - без перенумерации)
+    std::vector<int> internalIndex;  // Исходный номер вершины -> внутренний
+    mutable PhaseTimings timings;  // Время этапов
+    mutable std::chrono::steady_clock::time_point phaseStart;  // Начало текущего этапа
+    int vertices;  // Количество вершин в графе
+    ThreadPool* pool;  // Пул потоков для параллельного режима (nullptr - один поток)
+    
+    // Начинает отсчет времени этапа
+    void startPhase() const {
+        phaseStart = std::chrono::steady_clock::now();
+    }
+    
+    // Возвращает время с начала этапа в секундах и начинает следующий этап
+    double finishPhase() const {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - phaseStart).count();
+        phaseStart = now;
+        return seconds;
+    }
+    
+    // Вызывает body(Direction{}, Storage{}) с политиками typed:: хранимого
+    // графа. Режим выбирается здесь один раз, а тело цикла компилируется
+    // отдельно для каждого сочетания направленности и хранения, поэтому во
+    // внутренних циклах нет проверок storage и directed
+    template <typename F>
+    decltype(auto) withPolicies(F&& body) const {
+        requireAdjacency();
+        if (storage == Storage::Dense) {
+            if (directed) return body(typed::Directed{}, typed::DenseStorage{});
+            return body(typed::Undirected{}, typed::DenseStorage{});
+        }
+        if (directed) return body(typed::Directed{}, typed::SparseStorage{});
+        return body(typed::Undirected{}, typed::SparseStorage{});
+    }
+    
+    template <typename Store>
+    static constexpr bool kDenseStore = std::is_same_v<Store, typed::DenseStorage>;
+    
+    // Есть ли ребро a - b (индексы с 0) в хранимой смежности
+    template <typename Store>
+    bool storedEdge(int a, int b) const {
+        if constexpr (kDenseStore<Store>) {
+            return adjacencyMatrix.test(a, b);
+        } else {
+            return adjacencyLists.contains(a, b);
+        }
+    }
+    
+    // Степень вершины по хранимой смежности: popcount строки или длина списка
+    template <typename Store>
+    int storedRowCount(int v) const {
+        if constexpr (kDenseStore<Store>) {
+            return adjacencyMatrix.rowCount(v);
+        } else {
+            return adjacencyLists.rowCount(v);
+        }
+    }
+    
+    // Вызывает f(u) для каждого соседа u вершины v. Изменения CSR должны
+    // быть слиты заранее (sparseAdjacency)
+    template <typename Store, typename F>
+    void forEachStoredNeighbor(int v, F&& f) const {
+        if constexpr (kDenseStore<Store>) {
+            const std::uint64_t* row = adjacencyMatrix.row(v);
+            for (std::size_t w = 0; w < adjacencyMatrix.wordsPerRow(); ++w) {
+                for (std::uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+                    f(static_cast<int>(w * 64) + std::countr_zero(bits));
+                }
+            }
+        } else {
+            for (const int* p = adjacencyLists.begin(v); p != adjacencyLists.end(v); ++p) {
+                f(*p);
+            }
+        }
+    }
+    
+    // Изменения CSR копятся по неупорядоченным парам вершин, поэтому дуги
+    // ориентированного графа в CSR изменять нельзя (матрицу - можно)
+    template <typename Direction, typename Store>
+    static void requireEditableEdges() {
+        if constexpr (Direction::kDirected && !kDenseStore<Store>) {
+            throw GraphError("Изменение дуг ориентированного графа, заданного списком, не поддерживается");
+        }
+    }
+    
+    // Добавляет ребро u - v (номера с 1) при заданных политиках; степени
+    // концов и гистограмма степеней обновляются за O(1)
+    template <typename Direction, typename Store>
+    bool insertEdge(int u, int v) {
+        requireEditableEdges<Direction, Store>();
+        int a = vertexIndex(u), b = vertexIndex(v);
+        if (a == b) {
+            throw GraphError("На главной диагонали должны быть нули");
+        }
+        if (storedEdge<Store>(a, b)) {
+            return false;
+        }
+        if constexpr (kDenseStore<Store>) {
+            adjacencyMatrix.set(a, b);
+            if constexpr (!Direction::kDirected) adjacencyMatrix.set(b, a);
+        } else {
+            adjacencyLists.insert(a, b);
+        }
+        degreeIndex.increment(a);
+        if constexpr (Direction::kDirected) {
+            inDegreeIndex.increment(b);
+        } else {
+            degreeIndex.increment(b);
+        }
+        return true;
+    }
+    
+    // Удаляет ребро u - v (номера с 1) при заданных политиках
+    template <typename Direction, typename Store>
+    bool eraseEdge(int u, int v) {
+        requireEditableEdges<Direction, Store>();
+        int a = vertexIndex(u), b = vertexIndex(v);
+        if (!storedEdge<Store>(a, b)) {
+            return false;
+        }
+        if constexpr (kDenseStore<Store>) {
+            adjacencyMatrix.reset(a, b);
+            if constexpr (!Direction::kDirected) adjacencyMatrix.reset(b, a);
+        } else {
+            adjacencyLists.erase(a, b);
+        }
+        degreeIndex.decrement(a);
+        if constexpr (Direction::kDirected) {
+            inDegreeIndex.decrement(b);
+        } else {
+            degreeIndex.decrement(b);
+        }
+        return true;
+    }
+    
+    // Вызывает body(begin, end) для блоков строк [0, rows): параллельно,
+    // если задан пул и граф достаточно велик, иначе одним вызовом
+    void forEachRowBlock(int rows, const std::function<void(int, int)>& body) const {
+        if (!pool || rows < kParallelThreshold) {
+            body(0, rows);
+            return;
+        }
+        pool->parallelFor(rows, kRowBlock, [&](std::size_t begin, std::size_t end) {
+            body(static_cast<int>(begin), static_cast<int>(end));
+        });
+    }
+    
+    // Проверяет корректность матрицы смежности и одновременно считает степени
+    // Взято из решения DeepSeek
+    // Добавлены подробные проверки:
+    // - Пустая матрица
+    // - Несимметричная матрица
+    // - Ненулевые элементы на диагонали
+    // Значения, отличные от 0 и 1, отсекаются еще при чтении, так как
+    // упакованная матрица хранит только биты.
+    // Матрица обходится блоками 64 x 64: блок (I, J) верхнего треугольника
+    // сравнивается с транспонированным блоком (J, I), так что каждая пара
+    // проверяется один раз и без обхода по столбцам. Попутно popcount слов
+    // обоих блоков добавляется к степеням их строк - каждое слово матрицы
+    // читается из памяти ровно один раз.
+    // Блочные строки обрабатываются параллельно. Каждое нарушение получает
+    // ключ 2 * строка (+1 для несимметричности, так как диагональ строки
+    // проверяется первой); сообщается нарушение с наименьшим ключом, то есть
+    // то же, что нашел бы последовательный обход. Потоки прекращают работу,
+    // как только их строки не могут дать меньший ключ
+    std::vector<int> validateMatrix() const {
+        if (adjacencyMatrix.empty()) {
+            throw GraphError("Пустая матрица смежности");
+        }
+        
+        int size = adjacencyMatrix.dimension();
+        int tiles = adjacencyMatrix.tileCount();
+        std::vector<int> degrees(size, 0);
+        std::atomic<long long> firstViolation{LLONG_MAX};
+        auto report = [&](long long key) {
+            long long current = firstViolation.load(std::memory_order_relaxed);
+            while (key < current && !firstViolation.compare_exchange_weak(current, key)) {
+            }
+        };
+        // Степени строк блока J пополняют разные потоки, поэтому сложение атомарное
+        auto addDegree = [&](int row, int count) {
+            if (row < size && count != 0) {
+                std::atomic_ref<int>(degrees[row]).fetch_add(count, std::memory_order_relaxed);
+            }
+        };
+        
+        // Проверка симметричности и диагонали
+        forEachRowBlock(size, [&](int begin, int end) {
+            alignas(64) std::uint64_t upper[64];
+            alignas(64) std::uint64_t lower[64];
+            for (int tileRow = begin / 64; tileRow * 64 < end; ++tileRow) {
+                long long base = 64LL * tileRow;
+                int rowDegrees[64] = {};
+                for (int tileColumn = tileRow; tileColumn < tiles; ++tileColumn) {
+                    if (2 * base >= firstViolation.load(std::memory_order_relaxed)) {
+                        return;
+                    }
+                    adjacencyMatrix.loadTile(tileRow, tileColumn, upper);
+                    for (int k = 0; k < 64; ++k) {
+                        rowDegrees[k] += std::popcount(upper[k]);
+                    }
+                    if (tileColumn == tileRow) {
+                        std::copy(upper, upper + 64, lower);
+                    } else {
+                        adjacencyMatrix.loadTile(tileColumn, tileRow, lower);
+                        for (int k = 0; k < 64; ++k) {
+                            addDegree(tileColumn * 64 + k, std::popcount(lower[k]));
+                        }
+                    }
+                    transposeTile(lower);
+                    for (int k = 0; k < 64; ++k) {
+                        if (tileColumn == tileRow && ((upper[k] >> k) & 1)) {
+                            report(2 * (base + k));
+                            break;
+                        }
+                        if (upper[k] != lower[k]) {
+                            report(2 * (base + k) + 1);
+                            break;
+                        }
+                    }
+                }
+                for (int k = 0; k < 64; ++k) {
+                    addDegree(static_cast<int>(base) + k, rowDegrees[k]);
+                }
+            }
+        });
+        
+        if (firstViolation != LLONG_MAX) {
+            if (firstViolation % 2 == 0) {
+                throw GraphError("На главной диагонали должны быть нули");
+            }
+            throw GraphError("Матрица смежности должна быть симметричной");
+        }
+        return degrees;
+    }
+
+    // Считает для каждой вершины число треугольников, в которые она входит
+    // Матрица: для каждого ребра i - j (i < j) число общих соседей c равно
+    // popcount(строка i & строка j); c добавляется к обеим вершинам, и так как
+    // каждый треугольник вершины i учтен по двум ее ребрам, итог делится на 2.
+    // CSR: ребра ориентируются от вершины меньшей степени к большей (при равенстве -
+    // по номеру), после чего каждый треугольник находится ровно один раз слиянием
+    // двух коротких отсортированных списков исходящих ребер. Ориентация по степени
+    // ограничивает длину исходящего списка величиной O(sqrt(m))
+    std::vector<long long> countTriangles() const {
+        std::vector<long long> triangles(vertices, 0);
+        auto addTriangles = [&](int v, long long count) {
+            if (count != 0) {
+                std::atomic_ref<long long>(triangles[v]).fetch_add(count, std::memory_order_relaxed);
+            }
+        };
+        
+        if (storage == Storage::Dense) {
+            std::size_t words = adjacencyMatrix.wordsPerRow();
+            forEachRowBlock(vertices, [&](int begin, int end) {
+                for (int i = begin; i < end; ++i) {
+                    const std::uint64_t* rowI = adjacencyMatrix.row(i);
+                    long long own = 0;
+                    std::size_t first = static_cast<std::size_t>(i + 1) / 64;
+                    for (std::size_t w = first; w < words; ++w) {
+                        std::uint64_t bits = rowI[w];
+                        if (w == first) {
+                            bits &= ~std::uint64_t{0} << ((i + 1) % 64);
+                        }
+                        for (; bits != 0; bits &= bits - 1) {
+                            int j = static_cast<int>(w * 64) + std::countr_zero(bits);
+                            long long common = static_cast<long long>(
+                                countCommonBits(rowI, adjacencyMatrix.row(j), words));
+                            own += common;
+                            addTriangles(j, common);
+                        }
+                    }
+                    addTriangles(i, own);
+                }
+            });
+            for (long long& t : triangles) {
+                t /= 2;
+            }
+            return triangles;
+        }
+        
+        // Исходящие ребра в порядке (степень, номер); списки остаются
+        // отсортированными по номеру, так как списки CSR отсортированы
+        const CsrAdjacency& lists = sparseAdjacency();
+        auto precedes = [&](int u, int v) {
+            int du = lists.rowCount(u), dv = lists.rowCount(v);
+            return du < dv || (du == dv && u < v);
+        };
+        std::vector<std::size_t> offsets(static_cast<std::size_t>(vertices) + 1, 0);
+        for (int u = 0; u < vertices; ++u) {
+            offsets[u + 1] = offsets[u] + std::count_if(lists.begin(u), lists.end(u),
+                                                        [&](int v) { return precedes(u, v); });
+        }
+        std::vector<int> forward(offsets[vertices]);
+        for (int u = 0; u < vertices; ++u) {
+            std::copy_if(lists.begin(u), lists.end(u), forward.begin() + static_cast<std::ptrdiff_t>(offsets[u]),
+                         [&](int v) { return precedes(u, v); });
+        }
+        
+        forEachRowBlock(vertices, [&](int begin, int end) {
+            for (int u = begin; u < end; ++u) {
+                const int* uFirst = forward.data() + offsets[u];
+                const int* uLast = forward.data() + offsets[u + 1];
+                long long own = 0;
+                for (const int* p = uFirst; p != uLast; ++p) {
+                    int v = *p;
+                    const int* a = uFirst;
+                    const int* b = forward.data() + offsets[v];
+                    const int* bLast = forward.data() + offsets[v + 1];
+                    long long shared = 0;
+                    while (a != uLast && b != bLast) {
+                        if (*a < *b) {
+                            ++a;
+                        } else if (*b < *a) {
+                            ++b;
+                        } else {
+                            addTriangles(*a, 1);
+                            ++shared;
+                            ++a;
+                            ++b;
+                        }
+                    }
+                    own += shared;
+                    addTriangles(v, shared);
+                }
+                addTriangles(u, own);
+            }
+        });
+        return triangles;
+    }
+    
+    // Строит ядерное разложение алгоритмом Батагели - Заверсника за O(n + m)
+    // Вершины лежат в массиве, упорядоченном по текущей степени, и границы
+    // корзин (блоков одной степени) берутся из гистограммы DegreeIndex.
+    // Вершины снимаются в порядке возрастания степени; у соседа с большей
+    // степенью она уменьшается на 1 - сосед меняется местами с первой
+    // вершиной своей корзины, и граница корзины сдвигается, поэтому массив
+    // остается упорядоченным без перестановок. Степень вершины на момент
+    // снятия и есть ее ядерное число
+    CoreDecomposition decomposeCores(const DegreeIndex& index) const {
+        CoreDecomposition result;
+        result.core = index.values();
+        std::vector<int>& degree = result.core;
+        std::vector<int>& order = result.order;
+        order.resize(vertices);
+        std::vector<int> position(vertices);
+        std::vector<int> binStart(static_cast<std::size_t>(index.maxDegree()) + 1, 0);
+        for (int d = 1; d <= index.maxDegree(); ++d) {
+            binStart[d] = binStart[d - 1] + index.verticesWithDegree(d - 1);
+        }
+        {
+            std::vector<int> cursor(binStart);
+            for (int v = 0; v < vertices; ++v) {
+                position[v] = cursor[degree[v]]++;
+                order[position[v]] = v;
+            }
+        }
+        
+        if (storage == Storage::Sparse) {
+            sparseAdjacency();
+        }
+        auto lower = [&](int v, int u) {
+            if (degree[u] <= degree[v]) return;
+            int du = degree[u];
+            int first = binStart[du];
+            int w = order[first];
+            if (w != u) {
+                std::swap(order[first], order[position[u]]);
+                position[w] = position[u];
+                position[u] = first;
+            }
+            ++binStart[du];
+            --degree[u];
+        };
+        withPolicies([&](auto, auto store) {
+            for (int k = 0; k < vertices; ++k) {
+                int v = order[k];
+                forEachStoredNeighbor<decltype(store)>(v, [&](int u) { lower(v, u); });
+                result.degeneracy = std::max(result.degeneracy, degree[v]);
+            }
+        });
+        return result;
+    }
+    
+    // Находит компоненты связности
+    // Матрица: поиск в ширину, где фронт и множество непосещенных вершин -
+    // битовые множества. Следующий фронт - OR строк вершин фронта, маскированный
+    // непосещенными; слова, где непосещенных не осталось, пропускаются. Каждая
+    // строка матрицы читается ровно один раз, а слова следующего фронта
+    // независимы и делятся между потоками пула без синхронизации.
+    // CSR: система непересекающихся множеств без блокировок - корни
+    // связываются CAS-операцией (больший номер к меньшему), пути сокращаются
+    // вдвое при поиске. Ребра обрабатываются блоками строк на пуле потоков
+    ComponentSummary findComponents() const {
+        ComponentSummary summary;
+        if (storage == Storage::Dense) {
+            std::size_t words = adjacencyMatrix.wordsPerRow();
+            std::vector<std::uint64_t> unvisited(words, 0);
+            std::vector<std::uint64_t> next(words, 0);
+            for (int v = 0; v < vertices; ++v) {
+                unvisited[v / 64] |= std::uint64_t{1} << (v % 64);
+            }
+            std::vector<int> frontier;
+            std::size_t cursor = 0;
+            auto expand = [&](std::size_t begin, std::size_t end) {
+                std::fill(next.begin() + static_cast<std::ptrdiff_t>(begin),
+                          next.begin() + static_cast<std::ptrdiff_t>(end), std::uint64_t{0});
+                for (int v : frontier) {
+                    const std::uint64_t* row = adjacencyMatrix.row(v);
+                    for (std::size_t w = begin; w < end; ++w) {
+                        next[w] |= row[w] & unvisited[w];
+                    }
+                }
+                for (std::size_t w = begin; w < end; ++w) {
+                    unvisited[w] &= ~next[w];
+                }
+            };
+            
+            while (true) {
+                while (cursor < words && unvisited[cursor] == 0) {
+                    ++cursor;
+                }
+                if (cursor == words) {
+                    break;
+                }
+                int start = static_cast<int>(cursor * 64) + std::countr_zero(unvisited[cursor]);
+                unvisited[cursor] &= unvisited[cursor] - 1;
+                frontier.assign(1, start);
+                int size = 1;
+                while (!frontier.empty()) {
+                    // Поиск идет только по словам от первого непосещенного
+                    if (pool && vertices >= kParallelThreshold) {
+                        pool->parallelFor(words - cursor, BitMatrix::kWordsPerLine,
+                                          [&](std::size_t begin, std::size_t end) {
+                                              expand(cursor + begin, cursor + end);
+                                          });
+                    } else {
+                        expand(cursor, words);
+                    }
+                    frontier.clear();
+                    for (std::size_t w = cursor; w < words; ++w) {
+                        for (std::uint64_t bits = next[w]; bits != 0; bits &= bits - 1) {
+                            frontier.push_back(static_cast<int>(w * 64) + std::countr_zero(bits));
+                        }
+                    }
+                    size += static_cast<int>(frontier.size());
+                }
+                ++summary.count;
+                summary.largest = std::max(summary.largest, size);
+            }
+            return summary;
+        }
+        
+        const CsrAdjacency& lists = sparseAdjacency();
+        std::vector<int> parent(vertices);
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find = [&](int v) {
+            while (true) {
+                int p = std::atomic_ref<int>(parent[v]).load(std::memory_order_relaxed);
+                if (p == v) {
+                    return v;
+                }
+                int grandparent = std::atomic_ref<int>(parent[p]).load(std::memory_order_relaxed);
+                if (p != grandparent) {
+                    std::atomic_ref<int>(parent[v]).compare_exchange_weak(p, grandparent, std::memory_order_relaxed);
+                }
+                v = grandparent;
+            }
+        };
+        forEachRowBlock(vertices, [&](int begin, int end) {
+            for (int u = begin; u < end; ++u) {
+                for (const int* p = lists.begin(u); p != lists.end(u) && *p < u; ++p) {
+                    int a = find(u), b = find(*p);
+                    while (a != b) {
+                        if (a < b) {
+                            std::swap(a, b);
+                        }
+                        int expected = a;
+                        if (std::atomic_ref<int>(parent[a]).compare_exchange_strong(expected, b, std::memory_order_relaxed)) {
+                            break;
+                        }
+                        a = find(a);
+                        b = find(b);
+                    }
+                }
+            }
+        });
+        
+        std::vector<int> sizes(vertices, 0);
+        for (int v = 0; v < vertices; ++v) {
+            ++sizes[find(v)];
+        }
+        for (int size : sizes) {
+            if (size > 0) {
+                ++summary.count;
+                summary.largest = std::max(summary.largest, size);
+            }
+        }
+        return summary;
+    }
+    
+    // Читает матрицу смежности n x n после строки с количеством вершин
+    // Взято из решения DeepSeek
+    // Строки разбираются векторным сканером прямо в упакованную матрицу
+    void readMatrix(TextScanner& scanner) {
+        if (vertices <= 0 || vertices > kMaxDenseVertices) {
+            throw GraphError("Недопустимое количество вершин: " + std::to_string(vertices) + 
+                            " (должно быть от 1 до " + std::to_string(kMaxDenseVertices) + ")");
+        }
+        
+        storage = Storage::Dense;
+        adjacencyMatrix = BitMatrix(vertices);
+        for (int i = 0; i < vertices; ++i) {
+            scanner.readBitRow(adjacencyMatrix.row(i), vertices, i);
+        }
+        timings.parse += finishPhase();
+        
+        if (directed) {
+            readDirectedDegrees();
+        } else {
+            degreeIndex.assign(validateMatrix());
+        }
+        timings.validate += finishPhase();
+    }
+    
+    // Читает мультиграф: матрицу кратностей (ячейки >= 0, петли разрешены)
+    // или список ребер, где ребра могут повторяться. Матрица хранится в
+    // typed::DenseStorage с ячейками int, список - в typed::SparseStorage.
+    // Как в решении GPT-4o, петля неориентированного графа дает вершине 2.
+    // Граф нужен только для подсчета степеней и после него не хранится
+    template <typename Direction>
+    void readMultigraph(TextScanner& scanner, bool edgeList, long long edgeCount) {
+        auto takeDegrees = [&](const auto& graph) {
+            graph.validate();
+            degreeIndex.assign(graph.degrees());
+            if constexpr (Direction::kDirected) {
+                inDegreeIndex.assign(graph.inDegrees());
+            }
+        };
+        if (edgeList) {
+            if (vertices <= 0 || edgeCount < 0) {
+                throw GraphError("Недопустимое количество вершин или ребер: " + std::to_string(vertices) +
+                                " " + std::to_string(edgeCount));
+            }
+            typed::Graph<Direction, typed::SparseStorage, int, typed::MultiEdges> graph(vertices);
+            for (long long k = 0; k < edgeCount; ++k) {
+                int u, v;
+                if (!scanner.readInt(u) || !scanner.readInt(v)) {
+                    throw GraphError("Ошибка при чтении ребра " + std::to_string(k + 1));
+                }
+                if (u < 1 || u > vertices || v < 1 || v > vertices) {
+                    throw GraphError("Недопустимый номер вершины в ребре " + std::to_string(k + 1) +
+                                    ": " + std::to_string(u) + " " + std::to_string(v));
+                }
+                graph.addEdge(u - 1, v - 1);
+            }
+            timings.parse += finishPhase();
+            takeDegrees(graph);
+        } else {
+            if (vertices <= 0 || vertices > kMaxMultigraphVertices) {
+                throw GraphError("Недопустимое количество вершин: " + std::to_string(vertices) + 
+                                " (должно быть от 1 до " + std::to_string(kMaxMultigraphVertices) + ")");
+            }
+            typed::Graph<Direction, typed::DenseStorage, int, typed::MultiEdges> graph(vertices);
+            graph.readMatrix(scanner);
+            timings.parse += finishPhase();
+            takeDegrees(graph);
+        }
+        timings.degrees += finishPhase();
+        storage = Storage::Streamed;
+        adjacencyMatrix = BitMatrix();
+        adjacencyLists = CsrAdjacency();
+    }
+    
+    // Проверяет матрицу ориентированного графа (только нули на диагонали)
+    // и считает исходящие степени (popcount строк) и входящие (суммы столбцов)
+    void readDirectedDegrees() {
+        for (int i = 0; i < vertices; ++i) {
+            if (adjacencyMatrix.test(i, i)) {
+                throw GraphError("На главной диагонали должны быть нули");
+            }
+        }
+        std::vector<int> outDegrees(vertices);
+        forEachRowBlock(vertices, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                outDegrees[i] = adjacencyMatrix.rowCount(i);
+            }
+        });
+        degreeIndex.assign(std::move(outDegrees));
+        inDegreeIndex.assign(countInDegrees());
+    }
+    
+    // Входящие степени ориентированного графа
+    // Матрица: строки делятся на части по числу потоков, каждая часть
+    // накапливает суммы столбцов в своем ColumnCounter, затем суммы
+    // складываются. CSR: подсчет концов дуг
+    std::vector<int> countInDegrees() const {
+        std::vector<int> inDegrees(vertices, 0);
+        auto addCounts = [&](const std::vector<int>& counts) {
+            for (int j = 0; j < vertices; ++j) {
+                if (counts[j] != 0) {
+                    std::atomic_ref<int>(inDegrees[j]).fetch_add(counts[j], std::memory_order_relaxed);
+                }
+            }
+        };
+        withPolicies([&](auto, auto store) {
+            auto countRows = [&](std::size_t begin, std::size_t end) {
+                if constexpr (std::is_same_v<decltype(store), typed::DenseStorage>) {
+                    ColumnCounter counter(adjacencyMatrix.wordsPerRow());
+                    for (std::size_t i = begin; i < end; ++i) {
+                        counter.add(adjacencyMatrix.row(static_cast<int>(i)));
+                    }
+                    addCounts(counter.counts());
+                } else {
+                    std::vector<int> counts(vertices, 0);
+                    for (std::size_t i = begin; i < end; ++i) {
+                        for (const int* p = adjacencyLists.begin(static_cast<int>(i)); p != adjacencyLists.end(static_cast<int>(i)); ++p) {
+                            ++counts[*p];
+                        }
+                    }
+                    addCounts(counts);
+                }
+            };
+            
+            if (pool && vertices >= kParallelThreshold) {
+                std::size_t parts = pool->concurrency();
+                pool->parallelFor(vertices, (vertices + parts - 1) / parts, countRows);
+            } else {
+                countRows(0, vertices);
+            }
+        });
+        return inDegrees;
+    }
+    
+    // Читает список из edgeCount ребер "u v" (вершины нумеруются с 1)
+    // и строит по нему CSR. Петли и повторные ребра отклоняются с теми же
+    // сообщениями, что и для матрицы, симметричность обеспечивается построением
+    void readEdgeList(TextScanner& scanner, long long edgeCount) {
+        if (vertices <= 0) {
+            throw GraphError("Недопустимое количество вершин: " + std::to_string(vertices) + 
+                            " (должно быть положительным)");
+        }
+        if (edgeCount < 0) {
+            throw GraphError("Недопустимое количество ребер: " + std::to_string(edgeCount));
+        }
+        
+        // Ребро "u v" с разделителем занимает не меньше 4 байт, поэтому
+        // резерв ограничен остатком файла: ошибочное количество ребер в
+        // заголовке не выделяет память сверх размера входа и приводит к
+        // ошибке чтения ребра, а не к нехватке памяти
+        std::vector<std::pair<int, int>> edges;
+        edges.reserve(std::min(static_cast<std::size_t>(edgeCount), (scanner.remaining() + 1) / 4));
+        for (long long k = 0; k < edgeCount; ++k) {
+            int u, v;
+            if (!scanner.readInt(u) || !scanner.readInt(v)) {
+                throw GraphError("Ошибка при чтении ребра " + std::to_string(k + 1));
+            }
+            if (u < 1 || u > vertices || v < 1 || v > vertices) {
+                throw GraphError("Недопустимый номер вершины в ребре " + std::to_string(k + 1) +
+                                ": " + std::to_string(u) + " " + std::to_string(v));
+            }
+            if (u == v) {
+                throw GraphError("На главной диагонали должны быть нули");
+            }
+            edges.emplace_back(u - 1, v - 1);
+        }
+        timings.parse += finishPhase();
+        
+        storage = Storage::Sparse;
+        adjacencyLists = CsrAdjacency(vertices, edges, directed);
+        if (adjacencyLists.hasParallelEdges()) {
+            throw GraphError("Список ребер содержит повторные ребра");
+        }
+        timings.validate += finishPhase();
+        
+        // Для CSR степень - длина списка соседей, время O(n).
+        // Строки независимы, поэтому в параллельном режиме считаются блоками
+        std::vector<int> degrees(vertices);
+        forEachRowBlock(vertices, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                degrees[i] = adjacencyLists.rowCount(i);
+            }
+        });
+        degreeIndex.assign(std::move(degrees));
+        if (directed) {
+            inDegreeIndex.assign(countInDegrees());
+        }
+        timings.degrees += finishPhase();
+    }
+    
+    // Списки смежности CSR со слитыми изменениями addEdge/removeEdge
+    // Слияние выполняется здесь, до запуска параллельных обходов
+    const CsrAdjacency& sparseAdjacency() const {
+        adjacencyLists.compact();
+        return adjacencyLists;
+    }
+    
+    // Проверяет номер вершины (с 1) и возвращает индекс (с 0)
+    // во внутреннем порядке вершин
+    int vertexIndex(int v) const {
+        if (v < 1 || v > vertices) {
+            throw GraphError("Недопустимый номер вершины: " + std::to_string(v));
+        }
+        return internalIndex.empty() ? v - 1 : internalIndex[v - 1];
+    }
+    
+    // Исходный индекс (с 0) вершины с внутренним индексом v
+    int originalVertex(int v) const {
+        return originalIndex.empty() ? v : originalIndex[v];
+    }
+    
+    // Переставляет значения по вершинам из внутреннего порядка в исходный
+    template <typename T>
+    std::vector<T> inOriginalOrder(std::vector<T> values) const {
+        if (originalIndex.empty()) {
+            return values;
+        }
+        std::vector<T> result(values.size());
+        for (std::size_t k = 0; k < values.size(); ++k) {
+            result[originalIndex[k]] = values[k];
+        }
+        return result;
+    }
+    
+    // Индекс степеней в исходном порядке вершин
+    DegreeIndex inOriginalOrder(DegreeIndex index) const {
+        if (!originalIndex.empty()) {
+            index.scatter(originalIndex);
+        }
+        return index;
+    }
+    
+    // Переставляет значения по вершинам из исходного порядка во внутренний
+    template <typename T>
+    std::vector<T> inInternalOrder(std::vector<T> values) const {
+        if (originalIndex.empty()) {
+            return values;
+        }
+        std::vector<T> result(values.size());
+        for (std::size_t k = 0; k < values.size(); ++k) {
+            result[k] = values[originalIndex[k]];
+        }
+        return result;
+    }
+    
+    // Вершины по убыванию степени; при равных степенях сохраняется
+    // исходный порядок. Сортировка подсчетом по гистограмме DegreeIndex, O(n)
+    std::vector<int> degreeOrder() const {
+        std::vector<int> start(static_cast<std::size_t>(degreeIndex.maxDegree()) + 1, 0);
+        for (int d = degreeIndex.maxDegree() - 1; d >= 0; --d) {
+            start[d] = start[d + 1] + degreeIndex.verticesWithDegree(d + 1);
+        }
+        std::vector<int> order(vertices);
+        const std::vector<int>& degrees = degreeIndex.values();
+        for (int v = 0; v < vertices; ++v) {
+            order[start[degrees[v]]++] = v;
+        }
+        return order;
+    }
+    
+    // Обратный порядок Катхилла - Макки: поиск в ширину из непосещенной
+    // вершины наименьшей степени, соседи добавляются в очередь по
+    // возрастанию степени, итоговый порядок обращается. Соседи оказываются
+    // рядом по номерам, и обходы списков читают близкие участки памяти
+    std::vector<int> cuthillMcKeeOrder(const CsrAdjacency& lists) const {
+        std::vector<int> byDegree = degreeOrder();
+        std::reverse(byDegree.begin(), byDegree.end());
+        const std::vector<int>& degrees = degreeIndex.values();
+        std::vector<char> visited(vertices, 0);
+        std::vector<int> order;
+        order.reserve(vertices);
+        auto lessDegree = [&](int a, int b) {
+            return degrees[a] < degrees[b] || (degrees[a] == degrees[b] && a < b);
+        };
+        for (int start : byDegree) {
+            if (visited[start]) {
+                continue;
+            }
+            visited[start] = 1;
+            order.push_back(start);
+            for (std::size_t head = order.size() - 1; head < order.size(); ++head) {
+                std::size_t first = order.size();
+                int v = order[head];
+                for (const int* p = lists.begin(v); p != lists.end(v); ++p) {
+                    if (!visited[*p]) {
+                        visited[*p] = 1;
+                        order.push_back(*p);
+                    }
+                }
+                std::sort(order.begin() + static_cast<std::ptrdiff_t>(first), order.end(), lessDegree);
+            }
+        }
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+    
+    // Проверяет, что граф хранит ребра и может изменяться
+    void requireAdjacency() const {
+        if (storage == Storage::Streamed) {
+            throw GraphError("В потоковом режиме граф не хранится и не может изменяться");
+        }
+    }
+    
+    // Читает заголовок файла и определяет формат. Возвращает true для
+    // списка ребер (edgeCount заполняется); для матрицы сканер остается
+    // сразу после количества вершин
+    bool readHeader(TextScanner& scanner, long long& edgeCount) {
+        // Матрица может начинаться в той же строке, что и размер
+        vertices = 0;
+        scanner.readInt(vertices);
+        // Пустой список ребер ("n 0" без продолжения) отличается от матрицы,
+        // начатой в строке размера, отсутствием дальнейших токенов
+        TextScanner probe = scanner;
+        if (probe.hasTokenOnLine() && probe.readInt(edgeCount) && !probe.hasTokenOnLine() &&
+            (edgeCount != 0 || (probe.skipSpaces(), probe.atEnd()))) {
+            scanner = probe;
+            return true;
+        }
+        return false;
+    }
+    
+    // Записывает отчет по степеням вершин
+    // Взято из решения DeepSeek
+    // Добавлен вывод максимальной и минимальной степени вершин.
+    // Диапазон степеней, изолированные вершины и регулярность берутся из
+    // гистограммы DegreeIndex за O(1). Строки форматируются буферизованным
+    // ReportWriter, вывод побайтно совпадает с форматом std::ofstream
+    void writeReport(const std::string& filename, const DegreeIndex& index) const {
+        if (directed) {
+            writeDirectedReport(filename, index);
+            return;
+        }
+        // Компоненты связности и треугольники (в потоковом режиме граф
+        // не хранится, и они не считаются)
+        startPhase();
+        ComponentSummary components;
+        CoreDecomposition cores;
+        std::vector<long long> triangles;
+        if (storage != Storage::Streamed) {
+            components = findComponents();
+            cores = decomposeCores(index);
+            triangles = inOriginalOrder(countTriangles());
+            cores.core = inOriginalOrder(std::move(cores.core));
+        }
+        timings.analysis += finishPhase();
+        
+        // Значения по вершинам выводятся в исходной нумерации
+        const std::vector<int> degrees = inOriginalOrder(index.values());
+        
+        ReportWriter fout(filename);
+        
+        // Запись степеней вершин
+        fout << "Степени вершин графа:\n";
+        for (int i = 0; i < vertices; ++i) {
+            fout << "Вершина " << (i + 1) << ": " << degrees[i] << "\n";
+        }
+        
+        int minDegree = index.minDegree();
+        int maxDegree = index.maxDegree();
+        
+        fout << "\nМинимальная степень вершины: " << minDegree << "\n";
+        fout << "Максимальная степень вершины: " << maxDegree << "\n";
+        
+        // Анализ графа
+        fout << "\nАнализ графа:\n";
+        if (index.hasIsolated()) {
+            fout << "- Граф содержит изолированные вершины\n";
+        }
+        if (maxDegree == vertices - 1) {
+            fout << "- Граф содержит вершину, соединенную со всеми остальными\n";
+        }
+        if (index.isRegular() && minDegree > 0) {
+            fout << "- Граф является регулярным степени " << minDegree << "\n";
+        }
+        
+        writeDistribution(fout, "Распределение степеней:", index);
+        
+        if (storage != Storage::Streamed) {
+            fout << "\nКомпоненты связности:\n";
+            fout << "Количество компонент: " << components.count << "\n";
+            fout << "Размер наибольшей компоненты: " << components.largest << "\n";
+            if (components.count == 1) {
+                fout << "- Граф является связным\n";
+            }
+            writeCores(fout, cores);
+            writeClustering(fout, triangles, degrees);
+        }
+        
+        fout.close();
+        timings.report += finishPhase();
+    }
+    
+    // Записывает отчет ориентированного графа: исходящие (outIndex) и входящие
+    // степени вершин, их диапазоны, истоки (нет входящих дуг) и стоки (нет исходящих)
+    void writeDirectedReport(const std::string& filename, const DegreeIndex& outIndex) const {
+        startPhase();
+        const std::vector<int> outDegrees = inOriginalOrder(outIndex.values());
+        const std::vector<int> inDegrees = inOriginalOrder(inDegreeIndex.values());
+        ReportWriter fout(filename);
+        
+        fout << "Степени вершин ориентированного графа:\n";
+        for (int i = 0; i < vertices; ++i) {
+            fout << "Вершина " << (i + 1) << ": исходящая " << outDegrees[i]
+                 << ", входящая " << inDegrees[i] << "\n";
+        }
+        
+        fout << "\nМинимальная исходящая степень: " << outIndex.minDegree() << "\n";
+        fout << "Максимальная исходящая степень: " << outIndex.maxDegree() << "\n";
+        fout << "Минимальная входящая степень: " << inDegreeIndex.minDegree() << "\n";
+        fout << "Максимальная входящая степень: " << inDegreeIndex.maxDegree() << "\n";
+        
+        // Число истоков и стоков берется из гистограмм за O(1), списки - за O(n)
+        fout << "\nАнализ графа:\n";
+        auto writeVertices = [&](const char* title, const DegreeIndex& index, const std::vector<int>& degrees) {
+            fout << title << index.verticesWithDegree(0) << "\n";
+            if (index.hasIsolated()) {
+                const char* separator = "";
+                for (int i = 0; i < vertices; ++i) {
+                    if (degrees[i] == 0) {
+                        fout << separator << (i + 1);
+                        separator = " ";
+                    }
+                }
+                fout << "\n";
+            }
+        };
+        writeVertices("Истоков (вершин без входящих дуг): ", inDegreeIndex, inDegrees);
+        writeVertices("Стоков (вершин без исходящих дуг): ", outIndex, outDegrees);
+        
+        writeDistribution(fout, "Распределение исходящих степеней:", outIndex);
+        writeDistribution(fout, "Распределение входящих степеней:", inDegreeIndex);
+        
+        fout.close();
+        timings.report += finishPhase();
+    }
+    
+    // Записывает степени в машиночитаемом виде: CSV со строками
+    // "номер,степень" (для орграфа - "номер,исходящая,входящая") или
+    // двоичный файл с заголовком DegreeFileHeader
+    void writeDegreeTable(const std::string& filename, const DegreeIndex& index, ReportFormat format) const {
+        startPhase();
+        const std::vector<int> degrees = inOriginalOrder(index.values());
+        const std::vector<int> inDegrees = directed ? inOriginalOrder(inDegreeIndex.values()) : std::vector<int>();
+        // Проверка до открытия файла: ReportWriter обрезает существующий файл
+        if constexpr (std::endian::native != std::endian::little) {
+            if (format == ReportFormat::Binary) {
+                throw GraphError("Двоичный формат степеней поддерживается только на little-endian системах");
+            }
+        }
+        ReportWriter fout(filename, format == ReportFormat::Binary);
+        if (format == ReportFormat::Binary) {
+            DegreeFileHeader header{};
+            std::memcpy(header.magic, DegreeFileHeader::kMagic, sizeof(header.magic));
+            header.version = DegreeFileHeader::kVersion;
+            header.vertices = static_cast<std::uint64_t>(vertices);
+            header.minDegree = index.minDegree();
+            header.maxDegree = index.maxDegree();
+            header.flags = directed ? DegreeFileHeader::kDirected : 0;
+            fout.write(&header, sizeof(header));
+            fout.write(degrees.data(), degrees.size() * sizeof(int));
+            if (directed) {
+                fout.write(inDegrees.data(), degrees.size() * sizeof(int));
+            }
+        } else if (directed) {
+            fout << "vertex,out_degree,in_degree\n";
+            for (int i = 0; i < vertices; ++i) {
+                fout << (i + 1) << ',' << degrees[i] << ',' << inDegrees[i] << '\n';
+            }
+        } else {
+            fout << "vertex,degree\n";
+            for (int i = 0; i < vertices; ++i) {
+                fout << (i + 1) << ',' << degrees[i] << '\n';
+            }
+        }
+        fout.close();
+        timings.report += finishPhase();
+    }
+
+    // Записывает сводку распределения степеней (DegreeIndex::summarize) и
+    // гистограмму: число вершин каждой встречающейся степени
+    void writeDistribution(ReportWriter& fout, const char* title, const DegreeIndex& index) const {
+        DegreeIndex::Summary summary = index.summarize();
+        fout << "\n" << title << "\n";
+        fout << "Средняя степень: " << summary.mean << "\n";
+        fout << "Дисперсия степени: " << summary.variance << "\n";
+        fout << "Стандартное отклонение степени: " << std::sqrt(summary.variance) << "\n";
+        fout << "Медиана степени: " << summary.median << "\n";
+        for (std::size_t k = 0; k < DegreeIndex::kPercentiles.size(); ++k) {
+            fout << "Процентиль " << DegreeIndex::kPercentiles[k] << ": " << summary.percentiles[k] << "\n";
+        }
+        fout << "Гистограмма степеней:\n";
+        index.forEachDegree([&](int d, int count) {
+            fout << "Степень " << d << ": вершин " << count << "\n";
+        });
+    }
 
-// Основной класс для работы с графом
-// Объединяет функциональность из решений DeepSeek, Mistral и GPT-4o
-class Graph {
-private:
-    std::vector<std::vector<int>> adjacencyMatrix;  // Матрица смежности графа
-    int vertices;  // Количество вершин в графе
-    
-    // Проверяет корректность матрицы смежности
-    // Взято из решения DeepSeek
-    // Добавлены подробные проверки:
-    // - Пустая матрица
-    // - Несимметричная матрица
-    // - Ненулевые элементы на диагонали
-    // - Значения, отличные от 0 и 1
-    void validateMatrix() const {
-        // Проверка размерности
-        if (adjacencyMatrix.empty()) {
-            throw GraphError("Пустая матрица смежности");
+    // Записывает ядерные числа вершин, вырожденность, распределение ядерных
+    // чисел с размерами k-ядер (вершин с ядерным числом не меньше k) и
+    // порядок вырожденности
+    void writeCores(ReportWriter& fout, const CoreDecomposition& cores) const {
+        fout << "\nЯдерное разложение:\n";
+        for (int i = 0; i < vertices; ++i) {
+            fout << "Вершина " << (i + 1) << ": ядерное число " << cores.core[i] << "\n";
+        }
+        fout << "\nВырожденность (наибольшее ядерное число): " << cores.degeneracy << "\n";
+        std::vector<int> counts(static_cast<std::size_t>(cores.degeneracy) + 1, 0);
+        for (int k : cores.core) {
+            ++counts[k];
+        }
+        int coreSize = vertices;
+        for (int k = 0; k <= cores.degeneracy; ++k) {
+            fout << "Ядерное число " << k << ": вершин " << counts[k]
+                 << ", размер " << k << "-ядра " << coreSize << "\n";
+            coreSize -= counts[k];
+        }
+        fout << "Порядок вырожденности:";
+        for (int v : cores.order) {
+            fout << ' ' << (originalVertex(v) + 1);
         }
+        fout << "\n";
+    }
+
+    // Записывает число треугольников и локальный коэффициент кластеризации
+    // каждой вершины (доля связанных пар среди ее соседей), средний локальный
+    // и глобальный коэффициенты (3 * треугольники / число путей длины 2)
+    void writeClustering(ReportWriter& fout, const std::vector<long long>& triangles,
+                         const std::vector<int>& degrees) const {
+        fout << "\nТреугольники и кластеризация:\n";
+        long long tripleCount = 0;
+        long long vertexTriangles = 0;
+        double localSum = 0;
+        for (int i = 0; i < vertices; ++i) {
+            long long pairs = static_cast<long long>(degrees[i]) * (degrees[i] - 1) / 2;
+            double local = pairs > 0 ? static_cast<double>(triangles[i]) / static_cast<double>(pairs) : 0.0;
+            fout << "Вершина " << (i + 1) << ": треугольников " << triangles[i]
+                 << ", коэффициент кластеризации " << local << "\n";
+            tripleCount += pairs;
+            vertexTriangles += triangles[i];
+            localSum += local;
+        }
+        long long total = vertexTriangles / 3;
+        fout << "\nВсего треугольников: " << total << "\n";
+        fout << "Средний коэффициент кластеризации: " << localSum / vertices << "\n";
+        fout << "Глобальный коэффициент кластеризации: "
+             << (tripleCount > 0 ? 3.0 * static_cast<double>(total) / static_cast<double>(tripleCount) : 0.0)
+             << "\n";
+    }
+
+    // Загружает граф из двоичного файла .gbin
+    // Адъюнкция копируется из отображенного файла одним memcpy, проверка
+    // симметричности не нужна - файл записан из проверенного графа, а его
+    // целостность подтверждает контрольная сумма. При наличии секции
+    // степеней они берутся из файла без пересчета
+    void readBinary(const MappedFile& file) {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw GraphError("Формат .gbin поддерживается только на little-endian системах");
+        }
+        GraphFileHeader header;
+        if (file.size() < sizeof(header)) {
+            throw GraphError("Поврежденный файл .gbin: нет заголовка");
+        }
+        std::memcpy(&header, file.begin(), sizeof(header));
+        if (header.version != GraphFileHeader::kVersion) {
+            throw GraphError("Неподдерживаемая версия .gbin: " + std::to_string(header.version));
+        }
+        const char* payload = file.begin() + sizeof(header);
+        if (header.payloadBytes != file.size() - sizeof(header) ||
+            GraphFileHeader::fileChecksum(header, payload) != header.checksum) {
+            throw GraphError("Поврежденный файл .gbin: контрольная сумма не совпадает");
+        }
+        if (header.vertices == 0 || header.vertices > static_cast<std::uint64_t>(INT_MAX)) {
+            throw GraphError("Недопустимое количество вершин: " + std::to_string(header.vertices));
+        }
+        
+        vertices = static_cast<int>(header.vertices);
+        std::size_t n = header.vertices;
+        // Секция из count элементов по itemBytes байт. Размер проверяется по
+        // оставшимся байтам файла без переполнения до выделения памяти под
+        // секцию, поэтому испорченные размеры не приводят к огромным выделениям
+        auto section = [&](std::uint64_t count, std::size_t itemBytes) {
+            std::uint64_t remaining = static_cast<std::uint64_t>(file.end() - payload);
+            if (count > remaining / itemBytes) {
+                throw GraphError("Поврежденный файл .gbin: секция выходит за конец файла");
+            }
+            std::uint64_t padded = std::min(remaining, (count * itemBytes + 63) / 64 * 64);
+            const char* start = payload;
+            payload += padded;
+            return start;
+        };
         
-        int size = adjacencyMatrix.size();
-        for (const auto& row : adjacencyMatrix) {
-            if (row.size() != size) {
-                throw GraphError("Матрица смежности не является квадратной");
+        directed = (header.flags & GraphFileHeader::kDirected) != 0;
+        if (header.flags & GraphFileHeader::kSparse) {
+            std::uint64_t neighborCount = header.edgeCount;
+            if (!directed && __builtin_mul_overflow(neighborCount, std::uint64_t{2}, &neighborCount)) {
+                throw GraphError("Поврежденный файл .gbin: секция выходит за конец файла");
+            }
+            const char* offsetSection = section(n + 1, sizeof(std::uint64_t));
+            const char* neighborSection = section(neighborCount, sizeof(int));
+            std::vector<std::size_t> offsets(n + 1);
+            std::vector<int> neighbors(neighborCount);
+            std::memcpy(offsets.data(), offsetSection, offsets.size() * sizeof(std::uint64_t));
+            std::memcpy(neighbors.data(), neighborSection, neighbors.size() * sizeof(int));
+            // Дешевая проверка структуры, чтобы испорченные смещения не вывели за массив
+            bool consistent = offsets.front() == 0 && offsets.back() == neighbors.size() &&
+                              std::is_sorted(offsets.begin(), offsets.end()) &&
+                              std::all_of(neighbors.begin(), neighbors.end(),
+                                          [&](int v) { return v >= 0 && v < vertices; });
+            if (!consistent) {
+                throw GraphError("Поврежденный файл .gbin: некорректные списки смежности");
+            }
+            storage = Storage::Sparse;
+            adjacencyMatrix = BitMatrix();
+            adjacencyLists = CsrAdjacency(std::move(offsets), std::move(neighbors), directed);
+        } else {
+            if (vertices > kMaxDenseVertices) {
+                throw GraphError("Недопустимое количество вершин: " + std::to_string(vertices) + 
+                                " (должно быть от 1 до " + std::to_string(kMaxDenseVertices) + ")");
+            }
+            if (header.wordsPerRow != BitMatrix::strideFor(vertices)) {
+                throw GraphError("Поврежденный файл .gbin: неверная длина строки матрицы");
             }
+            const char* rows = section(n, header.wordsPerRow * sizeof(std::uint64_t));
+            storage = Storage::Dense;
+            adjacencyLists = CsrAdjacency();
+            adjacencyMatrix = BitMatrix(vertices);
+            std::memcpy(adjacencyMatrix.row(0), rows, adjacencyMatrix.bytes());
         }
         
-        // Проверка симметричности и диагонали
-        for (int i = 0; i < size; ++i) {
-            if (adjacencyMatrix[i][i] != 0) {
-                throw GraphError("На главной диагонали должны быть нули");
+        timings.parse += finishPhase();
+        
+        if (header.flags & GraphFileHeader::kDegrees) {
+            const char* degreeSection = section(n, sizeof(int));
+            std::vector<int> degrees(n);
+            std::memcpy(degrees.data(), degreeSection, n * sizeof(int));
+            // Степень ограничивает размер гистограммы DegreeIndex
+            if (std::any_of(degrees.begin(), degrees.end(), [&](int d) { return d < 0 || d > vertices; })) {
+                throw GraphError("Поврежденный файл .gbin: недопустимая степень вершины");
             }
-            for (int j = 0; j < size; ++j) {
-                if (adjacencyMatrix[i][j] != adjacencyMatrix[j][i]) {
-                    throw GraphError("Матрица смежности должна быть симметричной");
-                }
-                if (adjacencyMatrix[i][j] != 0 && adjacencyMatrix[i][j] != 1) {
-                    throw GraphError("Матрица смежности должна содержать только 0 и 1");
-                }
+            degreeIndex.assign(std::move(degrees));
+            // Диапазон степеней из заголовка сверяется с секцией степеней
+            if (degreeIndex.minDegree() != header.minDegree || degreeIndex.maxDegree() != header.maxDegree) {
+                throw GraphError("Поврежденный файл .gbin: диапазон степеней не совпадает с заголовком");
             }
+        } else {
+            std::vector<int> degrees(vertices);
+            withPolicies([&](auto, auto store) {
+                forEachRowBlock(vertices, [&](int begin, int end) {
+                    for (int i = begin; i < end; ++i) {
+                        degrees[i] = storedRowCount<decltype(store)>(i);
+                    }
+                });
+            });
+            degreeIndex.assign(std::move(degrees));
         }
+        if (directed) {
+            inDegreeIndex.assign(countInDegrees());
+        }
+        timings.degrees += finishPhase();
     }
 
 public:
     // Конструктор по умолчанию
-    Graph() : vertices(0) {}
+    Graph() : storage(Storage::Dense), vertices(0), pool(nullptr) {}
+    
+    int vertexCount() const { return vertices; }
+    
+    // Включает ориентированный режим до загрузки графа: матрица не обязана
+    // быть симметричной, строка "u v" списка - дуга u -> v. Считаются
+    // исходящие (degreeStatistics) и входящие (inDegreeStatistics) степени
+    void setDirected(bool value) { directed = value; }
+    
+    // Включает режим мультиграфа до загрузки графа: ячейки матрицы -
+    // кратности ребер, ребра списка могут повторяться, петли разрешены
+    void setMultigraph(bool value) { multigraph = value; }
+    bool isDirected() const { return directed; }
+    
+    // Входящие степени ориентированного графа в исходном порядке вершин
+    DegreeIndex inDegreeStatistics() const { return inOriginalOrder(inDegreeIndex); }
+    
+    // Время этапов загрузки, проверки, анализа и записи результатов
+    const PhaseTimings& phaseTimings() const { return timings; }
+    
+    // Степени вершин с гистограммой и диапазоном в исходном порядке вершин
+    // После reorderVertices возвращается переставленная копия
+    DegreeIndex degreeStatistics() const { return inOriginalOrder(degreeIndex); }
+    
+    // Степени во внутреннем порядке вершин (после reorderVertices он
+    // отличается от исходного) - без копирования, для сумм и гистограммы
+    const DegreeIndex& internalDegreeStatistics() const { return degreeIndex; }
+    
+    // Перенумеровывает вершины CSR в заданном порядке (после загрузки и
+    // изменений). Списки соседей, степени и гистограммы переставляются,
+    // а перестановка сохраняется: номера вершин в addEdge/removeEdge/hasEdge
+    // и в файлах результатов остаются исходными. Матрица не переставляется:
+    // строки плотного хранения и так читаются последовательно
+    void reorderVertices(VertexOrder order) {
+        if (order == VertexOrder::Original || storage != Storage::Sparse || vertices == 0) {
+            return;
+        }
+        startPhase();
+        const CsrAdjacency& lists = sparseAdjacency();
+        std::vector<int> newToOld = order == VertexOrder::DegreeDescending ? degreeOrder() : cuthillMcKeeOrder(lists);
+        std::vector<int> oldToNew(vertices);
+        for (int k = 0; k < vertices; ++k) {
+            oldToNew[newToOld[k]] = k;
+        }
+        
+        std::vector<std::size_t> offsets(static_cast<std::size_t>(vertices) + 1, 0);
+        for (int k = 0; k < vertices; ++k) {
+            offsets[k + 1] = offsets[k] + static_cast<std::size_t>(lists.rowCount(newToOld[k]));
+        }
+        std::vector<int> neighbors(offsets[vertices]);
+        forEachRowBlock(vertices, [&](int begin, int end) {
+            for (int k = begin; k < end; ++k) {
+                int* out = neighbors.data() + offsets[k];
+                int* last = std::transform(lists.begin(newToOld[k]), lists.end(newToOld[k]), out,
+                                           [&](int v) { return oldToNew[v]; });
+                std::sort(out, last);
+            }
+        });
+        adjacencyLists = CsrAdjacency(std::move(offsets), std::move(neighbors), directed);
+        
+        auto permute = [&](const std::vector<int>& values) {
+            std::vector<int> result(vertices);
+            for (int k = 0; k < vertices; ++k) {
+                result[k] = values[newToOld[k]];
+            }
+            return result;
+        };
+        degreeIndex.assign(permute(degreeIndex.values()));
+        if (directed) {
+            inDegreeIndex.assign(permute(inDegreeIndex.values()));
+        }
+        
+        // Перестановки складываются, если граф перенумеровывается повторно
+        std::vector<int> previous = std::move(originalIndex);
+        originalIndex.resize(vertices);
+        internalIndex.resize(vertices);
+        for (int k = 0; k < vertices; ++k) {
+            originalIndex[k] = previous.empty() ? newToOld[k] : previous[newToOld[k]];
+            internalIndex[originalIndex[k]] = k;
+        }
+        timings.reorder += finishPhase();
+    }
+    
+    // Включает параллельный режим: проверка и подсчет степеней выполняются
+    // блоками строк на потоках пула. nullptr возвращает однопоточный режим
+    void setThreadPool(ThreadPool* threadPool) {
+        pool = threadPool;
+    }
     
     // Читает граф из файла
     // Взято из решения DeepSeek
-    // Добавлена проверка количества вершин (от 1 до 100)
+    // Файл отображается в память и разбирается без потоков ввода.
+    // Двоичный файл .gbin распознается по сигнатуре GBIN, для текста
+    // формат определяется по первой строке:
+    // - "n" - далее матрица смежности n x n (плотное хранение)
+    // - "n m" - далее m ребер "u v" (разреженное хранение CSR)
     void readFromFile(const std::string& filename) {
-        std::ifstream fin(filename);
-        if (!fin) {
-            throw GraphError("Не удалось открыть входной файл: " + filename);
+        startPhase();
+        MappedFile file(filename);
+        if (file.size() >= sizeof(GraphFileHeader::kMagic) &&
+            std::memcmp(file.begin(), GraphFileHeader::kMagic, sizeof(GraphFileHeader::kMagic)) == 0) {
+            readBinary(file);
+            return;
+        }
+        TextScanner scanner(file.begin(), file.end());
+        
+        long long edgeCount;
+        bool edgeList = readHeader(scanner, edgeCount);
+        if (multigraph) {
+            if (directed) {
+                readMultigraph<typed::Directed>(scanner, edgeList, edgeCount);
+            } else {
+                readMultigraph<typed::Undirected>(scanner, edgeList, edgeCount);
+            }
+        } else if (edgeList) {
+            readEdgeList(scanner, edgeCount);
+        } else {
+            readMatrix(scanner);
         }
+    }
+    
+    // Читает матрицу смежности в потоковом режиме, не сохраняя ее
+    // Строки читаются по одной в буфер; степень строки (popcount) сразу
+    // добавляется в индекс степеней вместе с гистограммой и диапазоном. Для проверки симметричности хранятся
+    // только невыполненные обязательства: единица в [i][j] при j > i
+    // записывается в битовую строку pending[j] и сверяется с началом строки j,
+    // когда та будет прочитана, после чего pending[j] освобождается.
+    // Обязательство строки j занимает j бит, поэтому в худшем случае (плотная
+    // первая строка) пиковая память - половина матрицы в битах (n^2 / 16 байт),
+    // то есть в 32 раза меньше текстового файла; разобранные страницы
+    // файла возвращаются системе. Ограничение на размер матрицы не действует.
+    // Нарушение симметричности обнаруживается при чтении второй строки пары,
+    // поэтому при нескольких нарушениях может быть сообщено не то, что нашел
+    // бы обход сохраненной матрицы. Список ребер читается как обычно (CSR)
+    void streamFromFile(const std::string& filename) {
+        startPhase();
+        MappedFile file(filename);
+        TextScanner scanner(file.begin(), file.end());
         
-        // Чтение размера матрицы
-        fin >> vertices;
-        if (vertices <= 0 || vertices > 100) {
+        long long edgeCount;
+        if (readHeader(scanner, edgeCount)) {
+            readEdgeList(scanner, edgeCount);
+            return;
+        }
+        if (vertices <= 0) {
             throw GraphError("Недопустимое количество вершин: " + std::to_string(vertices) + 
-                            " (должно быть от 1 до 100)");
+                            " (должно быть положительным)");
         }
         
-        // Чтение матрицы смежности
-        adjacencyMatrix.resize(vertices, std::vector<int>(vertices));
-        for (int i = 0; i < vertices; ++i) {
-            for (int j = 0; j < vertices; ++j) {
-                if (!(fin >> adjacencyMatrix[i][j])) {
-                    throw GraphError("Ошибка при чтении элемента матрицы [" + 
-                                    std::to_string(i) + "][" + std::to_string(j) + "]");
+        // Страницы файла освобождаются порциями по 64 МБ
+        constexpr std::ptrdiff_t kReleaseStep = 64 << 20;
+        const char* released = file.begin();
+        
+        BitMatrix rowBuffer(1, vertices);
+        std::uint64_t* row = rowBuffer.row(0);
+        std::vector<std::vector<std::uint64_t>> pending(directed ? 0 : vertices);
+        // Для орграфа симметричность не проверяется, входящие степени
+        // накапливаются по строкам в байтовых счетчиках
+        std::unique_ptr<ColumnCounter> columns;
+        if (directed) {
+            columns = std::make_unique<ColumnCounter>(rowBuffer.wordsPerRow());
+        }
+        degreeIndex.assign({});
+        
+        // Цикл по строкам компилируется отдельно для каждой направленности
+        auto streamRows = [&](auto direction) {
+            for (int i = 0; i < vertices; ++i) {
+                rowBuffer.clearRow(0);
+                scanner.readBitRow(row, vertices, i);
+                if (rowBuffer.test(0, i)) {
+                    throw GraphError("На главной диагонали должны быть нули");
+                }
+                if constexpr (decltype(direction)::kDirected) {
+                    columns->add(row);
+                } else {
+                    // Начало строки [0, i) должно совпасть с обязательствами предыдущих строк
+                    std::size_t prefixWords = static_cast<std::size_t>(i) / 64;
+                    std::uint64_t tailMask = (std::uint64_t{1} << (i % 64)) - 1;
+                    const std::vector<std::uint64_t>& expected = pending[i];
+                    auto expectedWord = [&](std::size_t w) {
+                        return w < expected.size() ? expected[w] : std::uint64_t{0};
+                    };
+                    for (std::size_t w = 0; w < prefixWords; ++w) {
+                        if (row[w] != expectedWord(w)) {
+                            throw GraphError("Матрица смежности должна быть симметричной");
+                        }
+                    }
+                    if ((row[prefixWords] & tailMask) != expectedWord(prefixWords)) {
+                        throw GraphError("Матрица смежности должна быть симметричной");
+                    }
+                    std::vector<std::uint64_t>().swap(pending[i]);
+                    
+                    // Единицы правее диагонали становятся обязательствами строк j > i
+                    std::size_t words = (static_cast<std::size_t>(vertices) + 63) / 64;
+                    for (std::size_t w = prefixWords; w < words; ++w) {
+                        std::uint64_t bits = row[w];
+                        if (w == prefixWords) bits &= ~tailMask;
+                        for (; bits; bits &= bits - 1) {
+                            int j = static_cast<int>(w * 64) + std::countr_zero(bits);
+                            if (pending[j].empty()) {
+                                pending[j].assign((static_cast<std::size_t>(j) + 63) / 64, 0);
+                            }
+                            pending[j][i / 64] |= std::uint64_t{1} << (i % 64);
+                        }
+                    }
+                }
+                
+                degreeIndex.append(rowBuffer.rowCount(0));
+                
+                if (scanner.position() - released >= kReleaseStep) {
+                    file.release(scanner.position());
+                    released = scanner.position();
                 }
             }
+            if constexpr (decltype(direction)::kDirected) {
+                const std::vector<int>& counts = columns->counts();
+                inDegreeIndex.assign(std::vector<int>(counts.begin(), counts.begin() + vertices));
+            }
+        };
+        if (directed) {
+            streamRows(typed::Directed{});
+        } else {
+            streamRows(typed::Undirected{});
         }
-        
-        validateMatrix();
+        storage = Storage::Streamed;
+        adjacencyMatrix = BitMatrix();
+        adjacencyLists = CsrAdjacency();
+        timings.parse += finishPhase();
+    }
+    
+    // Проверяет наличие ребра u - v (вершины нумеруются с 1, как во входном файле)
+    bool hasEdge(int u, int v) const {
+        return withPolicies([&](auto, auto store) {
+            return storedEdge<decltype(store)>(vertexIndex(u), vertexIndex(v));
+        });
+    }
+    
+    // Добавляет ребро u - v. Возвращает false, если ребро уже было.
+    // Степени концов и гистограмма степеней обновляются за O(1), поэтому
+    // writeResults не требует повторного чтения и проверки графа
+    bool addEdge(int u, int v) {
+        return withPolicies([&](auto direction, auto store) {
+            return insertEdge<decltype(direction), decltype(store)>(u, v);
+        });
+    }
+    
+    // Удаляет ребро u - v. Возвращает false, если ребра не было
+    bool removeEdge(int u, int v) {
+        return withPolicies([&](auto direction, auto store) {
+            return eraseEdge<decltype(direction), decltype(store)>(u, v);
+        });
+    }
+    
+    // Добавляет изолированную вершину и возвращает ее номер (с 1)
+    // Пустой граф, созданный конструктором, так можно построить с нуля
+    int addVertex() {
+        requireAdjacency();
+        if (storage == Storage::Dense) {
+            if (vertices >= kMaxDenseVertices) {
+                throw GraphError("Недопустимое количество вершин: " + std::to_string(vertices + 1) + 
+                                " (должно быть от 1 до " + std::to_string(kMaxDenseVertices) + ")");
+            }
+            adjacencyMatrix.grow(vertices + 1);
+        } else {
+            adjacencyLists.addVertex();
+        }
+        degreeIndex.append(0);
+        if (directed) {
+            inDegreeIndex.append(0);
+        }
+        if (!originalIndex.empty()) {
+            originalIndex.push_back(vertices);
+            internalIndex.push_back(vertices);
+        }
+        return ++vertices;
+    }
+    
+    // Применяет изменения из текстового файла, по одной операции в строке:
+    // "+ u v" - добавить ребро, "- u v" - удалить ребро, "v" - добавить вершину.
+    // Добавление существующего и удаление отсутствующего ребра игнорируются.
+    // Политики графа выбираются один раз на весь файл (withPolicies)
+    void applyUpdates(const std::string& filename) {
+        MappedFile file(filename);
+        TextScanner scanner(file.begin(), file.end());
+        withPolicies([&](auto direction, auto store) {
+            using Direction = decltype(direction);
+            using Store = decltype(store);
+            for (long long k = 1;; ++k) {
+                char op;
+                if (!scanner.readSymbol(op)) {
+                    break;
+                }
+                int u, v;
+                if (op == 'v') {
+                    addVertex();
+                } else if ((op == '+' || op == '-') && scanner.readInt(u) && scanner.readInt(v)) {
+                    if (op == '+') {
+                        insertEdge<Direction, Store>(u, v);
+                    } else {
+                        eraseEdge<Direction, Store>(u, v);
+                    }
+                } else {
+                    throw GraphError("Ошибка в файле изменений " + filename + ": операция " + std::to_string(k));
+                }
+            }
+        });
     }
     
     // Вычисляет степени всех вершин графа
     // Взято из решения GPT-4o
-    // Использует std::count для подсчета единиц в строке матрицы
+    // Степени считаются один раз при загрузке: для матрицы - popcount'ом
+    // в совмещенном проходе validateMatrix, для CSR - по длинам списков,
+    // в потоковом режиме - по мере чтения строк.
+    // Степени возвращаются в исходном порядке вершин и после reorderVertices
     std::vector<int> calculateDegrees() const {
-        if (adjacencyMatrix.empty()) {
+        if (vertices == 0) {
             throw GraphError("Граф не инициализирован");
         }
-        
-        std::vector<int> degrees(vertices);
-        for (int i = 0; i < vertices; ++i) {
-            degrees[i] = std::count(adjacencyMatrix[i].begin(), adjacencyMatrix[i].end(), 1);
-        }
-        return degrees;
+        return inOriginalOrder(degreeIndex.values());
     }
     
     // Записывает результаты в файл
     // Взято из решения DeepSeek
-    // Добавлен вывод максимальной и минимальной степени вершин
+    // Добавлен вывод максимальной и минимальной степени вершин.
+    // Степени degrees - в исходном порядке вершин, как их возвращает calculateDegrees
     void writeResults(const std::string& filename, const std::vector<int>& degrees) const {
         if (degrees.size() != vertices) {
             throw GraphError("Размер вектора степеней не соответствует количеству вершин");
         }
         
-        std::ofstream fout(filename);
-        if (!fout) {
-            throw GraphError("Не удалось открыть выходной файл: " + filename);
+        // Гистограмма и диапазон степеней строятся за один проход; отчет
+        // принимает индекс во внутреннем порядке вершин
+        DegreeIndex index;
+        index.assign(inInternalOrder(degrees));
+        writeReport(filename, index);
+    }
+    
+    // Записывает результаты по степеням, которые граф поддерживает сам
+    // (посчитаны при загрузке и обновлены addEdge/removeEdge/addVertex)
+    // Диапазон степеней уже известен, поэтому повторный поиск не нужен.
+    // Кроме текстового отчета доступны CSV и двоичный массив степеней
+    void writeResults(const std::string& filename, ReportFormat format = ReportFormat::Text) const {
+        if (vertices == 0) {
+            throw GraphError("Граф не инициализирован");
         }
-        
-        // Запись степеней вершин
-        fout << "Степени вершин графа:\n";
-        for (int i = 0; i < vertices; ++i) {
-            fout << "Вершина " << (i + 1) << ": " << degrees[i] << "\n";
+        if (format == ReportFormat::Text) {
+            writeReport(filename, degreeIndex);
+        } else {
+            writeDegreeTable(filename, degreeIndex, format);
+        }
+    }
+    
+    // Сохраняет граф в двоичном формате .gbin (см. GraphFileHeader)
+    // При withDegrees в файл добавляются посчитанные степени, и следующая
+    // загрузка не пересчитывает их
+    void writeBinary(const std::string& filename, bool withDegrees = true) const {
+        if (vertices == 0) {
+            throw GraphError("Граф не инициализирован");
+        }
+        if (storage == Storage::Streamed) {
+            throw GraphError("В потоковом режиме матрица смежности не сохраняется");
+        }
+        if (!originalIndex.empty()) {
+            throw GraphError("Граф с перенумерованными вершинами не сохраняется в .gbin");
         }
         
-        // Нахождение максимальной и минимальной степени
-        auto [minIt, maxIt] = std::minmax_element(degrees.begin(), degrees.end());
-        int minDegree = *minIt;
-        int maxDegree = *maxIt;
+        // Секции собираются в один буфер, чтобы посчитать контрольную сумму
+        std::vector<char> payload;
+        auto append = [&](const void* data, std::size_t bytes) {
+            const char* begin = static_cast<const char*>(data);
+            payload.insert(payload.end(), begin, begin + bytes);
+            payload.resize((payload.size() + 63) / 64 * 64, 0);
+        };
         
-        fout << "\nМинимальная степень вершины: " << minDegree << "\n";
-        fout << "Максимальная степень вершины: " << maxDegree << "\n";
+        GraphFileHeader header{};
+        std::memcpy(header.magic, GraphFileHeader::kMagic, sizeof(header.magic));
+        header.version = GraphFileHeader::kVersion;
+        header.vertices = static_cast<std::uint64_t>(vertices);
+        const std::vector<int>& degrees = degreeIndex.values();
+        if (directed) {
+            header.flags |= GraphFileHeader::kDirected;
+        }
+        if (storage == Storage::Sparse) {
+            const CsrAdjacency& lists = sparseAdjacency();
+            const auto& offsets = lists.rowOffsets();
+            const auto& neighbors = lists.adjacency();
+            header.flags |= GraphFileHeader::kSparse;
+            header.edgeCount = lists.edgeCount();
+            std::vector<std::uint64_t> offsets64(offsets.begin(), offsets.end());
+            append(offsets64.data(), offsets64.size() * sizeof(std::uint64_t));
+            append(neighbors.data(), neighbors.size() * sizeof(int));
+        } else {
+            // После addVertex строки могут быть длиннее канонических,
+            // поэтому в файл пишется каноническая длина BitMatrix(n)
+            std::size_t stride = BitMatrix::strideFor(vertices);
+            header.wordsPerRow = stride;
+            header.edgeCount = std::accumulate(degrees.begin(), degrees.end(), 0ULL) / (directed ? 1 : 2);
+            std::vector<std::uint64_t> rows(static_cast<std::size_t>(vertices) * stride);
+            for (int i = 0; i < vertices; ++i) {
+                std::copy_n(adjacencyMatrix.row(i), std::min(stride, adjacencyMatrix.wordsPerRow()),
+                            rows.begin() + static_cast<std::ptrdiff_t>(i * stride));
+            }
+            append(rows.data(), rows.size() * sizeof(std::uint64_t));
+        }
+        if (withDegrees) {
+            header.flags |= GraphFileHeader::kDegrees;
+            header.minDegree = degreeIndex.minDegree();
+            header.maxDegree = degreeIndex.maxDegree();
+            append(degrees.data(), degrees.size() * sizeof(int));
+        }
+        header.payloadBytes = payload.size();
+        header.checksum = GraphFileHeader::fileChecksum(header, payload.data());
         
-        // Анализ графа
-        fout << "\nАнализ графа:\n";
-        if (minDegree == 0) {
-            fout << "- Граф содержит изолированные вершины\n";
+        std::ofstream fout(filename, std::ios::binary);
+        if (!fout) {
+            throw GraphError("Не удалось открыть выходной файл: " + filename);
         }
-        if (maxDegree == vertices - 1) {
-            fout << "- Граф содержит вершину, соединенную со всеми остальными\n";
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fout.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!fout) {
+            throw GraphError("Ошибка записи в файл: " + filename);
         }
-        if (minDegree == maxDegree && minDegree > 0) {
-            fout << "- Граф является регулярным степени " << minDegree << "\n";
+    }
+};
+
+// Ограничение суммарного объема данных, одновременно загруженных в пакетном режиме
+// Поток, которому не хватает бюджета, ждет, пока другие потоки освободят память
+class MemoryBudget {
+public:
+    explicit MemoryBudget(std::uint64_t limit) : available(limit), limit(limit) {}
+
+    // Резервирует bytes байт (не больше всего бюджета, чтобы большой файл
+    // мог обрабатываться в одиночку) и возвращает зарезервированный объем
+    std::uint64_t acquire(std::uint64_t bytes) {
+        bytes = std::min(bytes, limit);
+        std::unique_lock<std::mutex> lock(mutex);
+        released.wait(lock, [&] { return available >= bytes; });
+        available -= bytes;
+        return bytes;
+    }
+
+    void release(std::uint64_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            available += bytes;
+        }
+        released.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    std::uint64_t available;
+    std::uint64_t limit;
+};
+
+// Пакетная обработка множества графов: каталога или списка файлов
+// Каждый граф читается, проверяется и записывается отдельным объектом Graph
+// на одном из потоков пула; параллельность - между графами, а не внутри графа,
+// что для множества небольших графов убирает затраты на запуск процесса.
+// Ошибка в одном файле записывается в сводку и не останавливает остальные
+class BatchRunner {
+public:
+    // Параметры обработки, общие для всех графов пакета
+    struct Options {
+        bool directed = false;
+        bool multigraph = false;
+        ReportFormat format = ReportFormat::Text;
+        VertexOrder order = VertexOrder::Original;
+    };
+
+    BatchRunner(ThreadPool& pool, std::string outputDirectory, std::uint64_t memoryLimit, Options options)
+        : pool(pool), outputDirectory(std::move(outputDirectory)), budget(memoryLimit), options(options) {}
+
+    // Все обычные файлы каталога (кроме результатов прошлых запусков) по имени
+    static std::vector<std::string> listDirectory(const std::string& directory) {
+        std::vector<std::string> inputs;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            std::string name = entry.path().filename().string();
+            if (entry.is_regular_file() && !isOutputName(name)) {
+                inputs.push_back(entry.path().string());
+            }
+        }
+        if (error) {
+            throw GraphError("Не удалось прочитать каталог: " + directory);
+        }
+        std::sort(inputs.begin(), inputs.end());
+        return inputs;
+    }
+
+    // Пути из файла-списка, по одному в строке; пустые строки пропускаются
+    static std::vector<std::string> readManifest(const std::string& filename) {
+        std::ifstream fin(filename);
+        if (!fin) {
+            throw GraphError("Не удалось открыть список файлов: " + filename);
+        }
+        std::vector<std::string> inputs;
+        std::string line;
+        while (std::getline(fin, line)) {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            line.erase(0, line.find_first_not_of(" \t"));
+            if (!line.empty()) {
+                inputs.push_back(line);
+            }
+        }
+        return inputs;
+    }
+
+    // Обрабатывает все графы и записывает сводку; возвращает число ошибок
+    // Совпадение имен файлов результатов проверяется до запуска: иначе потоки
+    // писали бы один файл одновременно и один из результатов терялся бы
+    std::size_t run(const std::vector<std::string>& inputs) {
+        std::unordered_map<std::string, std::size_t> outputs;
+        for (std::size_t k = 0; k < inputs.size(); ++k) {
+            auto [it, inserted] = outputs.emplace(outputName(inputs[k]), k);
+            if (!inserted) {
+                throw GraphError("Файлы " + inputs[it->second] + " и " + inputs[k] +
+                                 " дают одинаковое имя результата: " + it->first);
+            }
+        }
+        std::filesystem::create_directories(outputDirectory);
+        std::vector<Result> results(inputs.size());
+        pool.parallelFor(inputs.size(), 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t k = begin; k < end; ++k) {
+                results[k] = process(inputs[k]);
+            }
+        });
+        writeSummary(inputs, results);
+        return static_cast<std::size_t>(std::count_if(results.begin(), results.end(),
+                                                      [](const Result& r) { return !r.error.empty(); }));
+    }
+
+    // Имя файла результатов для входного файла: полное имя файла (с
+    // расширением) и суффикс формата, например a.txt.degrees.txt
+    std::string outputName(const std::string& input) const {
+        std::filesystem::path path(input);
+        return (std::filesystem::path(outputDirectory) / (path.filename().string() + outputSuffix(options.format))).string();
+    }
+
+    // Имя файла сводки
+    std::string summaryName() const {
+        return (std::filesystem::path(outputDirectory) / kSummaryName).string();
+    }
+
+private:
+    static constexpr const char* kSummaryName = "summary.txt";
+    static constexpr std::array<ReportFormat, 3> kFormats = {ReportFormat::Text, ReportFormat::Csv, ReportFormat::Binary};
+
+    static std::string outputSuffix(ReportFormat format) {
+        switch (format) {
+            case ReportFormat::Csv: return ".degrees.csv";
+            case ReportFormat::Binary: return ".degrees.bin";
+            default: return ".degrees.txt";
+        }
+    }
+
+    // Итог обработки одного графа
+    struct Result {
+        std::string error;  // Пустая строка - граф обработан успешно
+        int vertices = 0;
+        unsigned long long edges = 0;
+        int minDegree = 0;
+        int maxDegree = 0;
+    };
+
+    static bool isOutputName(const std::string& name) {
+        return name == kSummaryName || std::any_of(kFormats.begin(), kFormats.end(), [&](ReportFormat format) {
+            std::string suffix = outputSuffix(format);
+            return name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+        });
+    }
+
+    // Читает один граф и пишет его отчет. Объем резервируется по размеру
+    // файла: он ограничивает сверху и отображение файла, и битовую матрицу
+    Result process(const std::string& input) {
+        Result result;
+        std::error_code error;
+        std::uint64_t size = std::filesystem::file_size(input, error);
+        std::uint64_t reserved = budget.acquire(error ? 0 : 2 * size);
+        try {
+            Graph graph;
+            graph.setDirected(options.directed);
+            graph.setMultigraph(options.multigraph);
+            graph.readFromFile(input);
+            graph.reorderVertices(options.order);
+            graph.writeResults(outputName(input), options.format);
+            // Сумма исходящих степеней орграфа - число дуг, неориентированного - удвоенное число ребер
+            const DegreeIndex& degrees = graph.internalDegreeStatistics();
+            result.vertices = graph.vertexCount();
+            result.edges = std::accumulate(degrees.values().begin(), degrees.values().end(), 0ULL) /
+                           (options.directed ? 1 : 2);
+            result.minDegree = degrees.minDegree();
+            result.maxDegree = degrees.maxDegree();
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        budget.release(reserved);
+        return result;
+    }
+
+    // Сводка: строка на каждый граф в порядке входного списка и общие итоги
+    void writeSummary(const std::vector<std::string>& inputs, const std::vector<Result>& results) const {
+        std::string filename = summaryName();
+        std::ofstream fout(filename);
+        if (!fout) {
+            throw GraphError("Не удалось открыть выходной файл: " + filename);
         }
         
-        fout.close();
+        std::size_t failed = 0;
+        unsigned long long totalVertices = 0, totalEdges = 0;
+        int minDegree = INT_MAX, maxDegree = 0;
+        for (std::size_t k = 0; k < inputs.size(); ++k) {
+            const Result& r = results[k];
+            if (!r.error.empty()) {
+                ++failed;
+                fout << inputs[k] << ": ошибка: " << r.error << "\n";
+                continue;
+            }
+            fout << inputs[k] << ": вершин " << r.vertices << ", ребер " << r.edges
+                 << ", степени от " << r.minDegree << " до " << r.maxDegree << "\n";
+            totalVertices += r.vertices;
+            totalEdges += r.edges;
+            minDegree = std::min(minDegree, r.minDegree);
+            maxDegree = std::max(maxDegree, r.maxDegree);
+        }
+        
+        fout << "\nВсего файлов: " << inputs.size() << "\n";
+        fout << "Обработано успешно: " << inputs.size() - failed << "\n";
+        fout << "С ошибками: " << failed << "\n";
+        if (failed < inputs.size()) {
+            fout << "Всего вершин: " << totalVertices << "\n";
+            fout << "Всего ребер: " << totalEdges << "\n";
+            fout << "Минимальная степень вершины: " << minDegree << "\n";
+            fout << "Максимальная степень вершины: " << maxDegree << "\n";
+        }
     }
+
+    ThreadPool& pool;
+    std::string outputDirectory;
+    MemoryBudget budget;
+    Options options;
 };
 
 // Основная функция программы
 // Взято из решения DeepSeek
 // Улучшена обработка ошибок с использованием try-catch
-int main() {
+// Параметры:
+// --threads N - число потоков (по умолчанию - все ядра);
+// --stream - потоковый режим для матриц, не помещающихся в память;
+// --input FILE / --output FILE - вместо FN1.txt / FN2.txt (вход может быть .gbin);
+// --save-binary FILE - сохранить загруженный граф со степенями в формате .gbin;
+// --updates FILE - применить изменения ребер и вершин (см. Graph::applyUpdates);
+// --format text|csv|binary - формат файла результатов (по умолчанию text - FN2.txt);
+// --timings - вывести в stderr время этапов (для бенчмарка benchmark.cpp);
+// --directed - ориентированный граф: исходящие и входящие степени, истоки и стоки;
+// --multigraph - мультиграф: кратные ребра и петли (петля дает вершине степень 2);
+// --reorder none|degree|rcm - перенумерация вершин списка ребер для локальности;
+// --batch DIR / --batch-list FILE - пакетная обработка всех файлов каталога или
+// файлов из списка, результаты и summary.txt пишутся в --output-dir (по умолчанию
+// batch_results), --batch-memory MB ограничивает объем одновременно загруженных данных;
+// --directed, --multigraph, --format и --reorder применяются к каждому графу пакета,
+// а --stream, --updates и --save-binary с пакетным режимом несовместимы
+int main(int argc, char* argv[]) {
     try {
-        Graph graph;
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        bool streaming = false;
+        std::string input = "FN1.txt";
+        std::string output = "FN2.txt";
+        std::string binaryOutput;
+        std::string updates;
+        std::string batchDirectory;
+        std::string batchList;
+        std::string outputDirectory = "batch_results";
+        std::uint64_t batchMemory = 1024;
+        ReportFormat format = ReportFormat::Text;
+        bool printTimings = false;
+        bool directed = false;
+        bool multigraph = false;
+        VertexOrder order = VertexOrder::Original;
+        for (int k = 1; k < argc; ++k) {
+            std::string arg = argv[k];
+            if (arg == "--threads" && k + 1 < argc) {
+                threads = std::max(1, std::stoi(argv[++k]));
+            } else if (arg == "--stream") {
+                streaming = true;
+            } else if (arg == "--timings") {
+                printTimings = true;
+            } else if (arg == "--directed") {
+                directed = true;
+            } else if (arg == "--multigraph") {
+                multigraph = true;
+            } else if (arg == "--input" && k + 1 < argc) {
+                input = argv[++k];
+            } else if (arg == "--output" && k + 1 < argc) {
+                output = argv[++k];
+            } else if (arg == "--save-binary" && k + 1 < argc) {
+                binaryOutput = argv[++k];
+            } else if (arg == "--updates" && k + 1 < argc) {
+                updates = argv[++k];
+            } else if (arg == "--format" && k + 1 < argc) {
+                std::string name = argv[++k];
+                if (name == "text") {
+                    format = ReportFormat::Text;
+                } else if (name == "csv") {
+                    format = ReportFormat::Csv;
+                } else if (name == "binary") {
+                    format = ReportFormat::Binary;
+                } else {
+                    throw GraphError("Неизвестный формат результатов: " + name);
+                }
+            } else if (arg == "--reorder" && k + 1 < argc) {
+                std::string name = argv[++k];
+                if (name == "none") {
+                    order = VertexOrder::Original;
+                } else if (name == "degree") {
+                    order = VertexOrder::DegreeDescending;
+                } else if (name == "rcm") {
+                    order = VertexOrder::ReverseCuthillMcKee;
+                } else {
+                    throw GraphError("Неизвестный порядок вершин: " + name);
+                }
+            } else if (arg == "--batch" && k + 1 < argc) {
+                batchDirectory = argv[++k];
+            } else if (arg == "--batch-list" && k + 1 < argc) {
+                batchList = argv[++k];
+            } else if (arg == "--output-dir" && k + 1 < argc) {
+                outputDirectory = argv[++k];
+            } else if (arg == "--batch-memory" && k + 1 < argc) {
+                batchMemory = std::max(1, std::stoi(argv[++k]));
+            } else {
+                throw GraphError("Неизвестный параметр: " + arg);
+            }
+        }
+        
+        ThreadPool pool(threads);
+        
+        // Пакетный режим: каждый граф обрабатывается однопоточно, потоки пула
+        // распределяются между графами
+        if (!batchDirectory.empty() || !batchList.empty()) {
+            if (streaming || !updates.empty() || !binaryOutput.empty()) {
+                throw GraphError("Параметры --stream, --updates и --save-binary не используются в пакетном режиме");
+            }
+            std::vector<std::string> inputs = batchDirectory.empty() ? BatchRunner::readManifest(batchList)
+                                                                     : BatchRunner::listDirectory(batchDirectory);
+            BatchRunner runner(pool, outputDirectory, batchMemory << 20, {directed, multigraph, format, order});
+            std::size_t failed = runner.run(inputs);
+            std::cout << "Обработано графов: " << inputs.size() - failed << " из " << inputs.size() << "\n";
+            std::cout << "Сводка сохранена в файл " << runner.summaryName() << "\n";
+            return failed == 0 ? 0 : 1;
+        }
         
-        // Чтение графа из файла
-        graph.readFromFile("FN1.txt");
+        Graph graph;
+        graph.setThreadPool(&pool);
+        graph.setDirected(directed);
+        graph.setMultigraph(multigraph);
+        if (streaming && multigraph) {
+            throw GraphError("Параметры --stream и --multigraph несовместимы");
+        }
         
-        // Вычисление степеней вершин
-        auto degrees = graph.calculateDegrees();
+        // Чтение графа из файла; степени вершин считаются при загрузке
+        if (streaming) {
+            graph.streamFromFile(input);
+        } else {
+            graph.readFromFile(input);
+        }
+        if (!updates.empty()) {
+            graph.applyUpdates(updates);
+        }
+        if (!binaryOutput.empty()) {
+            graph.writeBinary(binaryOutput);
+        }
+        graph.reorderVertices(order);
         
         // Запись результатов в файл
-        graph.writeResults("FN2.txt", degrees);
+        graph.writeResults(output, format);
+        
+        if (printTimings) {
+            const PhaseTimings& t = graph.phaseTimings();
+            std::cerr << "timings: parse=" << t.parse << " validate=" << t.validate
+                      << " degrees=" << t.degrees << " reorder=" << t.reorder << " analysis=" << t.analysis
+                      << " report=" << t.report << "\n";
+        }
         
         std::cout << "Расчет степеней вершин графа завершен успешно.\n";
-        std::cout << "Результаты сохранены в файл FN2.txt\n";
+        std::cout << "Результаты сохранены в файл " << output << "\n";
         
         return 0;
     } catch (const std::exception& e) {